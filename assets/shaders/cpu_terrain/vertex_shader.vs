@@ -1,7 +1,29 @@
 #version 450 core
 
+/*
+By default vertices store their position and texture coordinates (see
+grid_mesh). COMPACT_VERTICES reads just a height per vertex and derives
+the rest from gl_VertexID, the index of the vertex in the width x height
+grid (see compact_grid_mesh); ATTRIBUTELESS_VERTICES draws 6 vertices per
+quad without vertex data and fetches the heights from a height map.
+*/
+#if defined(COMPACT_VERTICES) || defined(ATTRIBUTELESS_VERTICES)
+uniform ivec2 grid_size;
+uniform float height_scale;
+#else
 layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec2 vertex_tex_coordinates;
+#endif
+
+#ifdef COMPACT_VERTICES
+layout (location = 0) in float vertex_height;
+#elif defined(ATTRIBUTELESS_VERTICES)
+// Heights already remapped through the Hermite curve
+uniform sampler2D height_map_sampler;
+
+// (column, row) offsets of the vertices of the 2 triangles of a quad, in the order of the indices of grid_mesh
+const ivec2 quad_corners[6] = ivec2[](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 0), ivec2(0, 1), ivec2(1, 1));
+#endif
 
 out vec2 tex_coordinates;
 
@@ -9,6 +31,20 @@ uniform mat4 proj_view_transform;
 
 void main()
 {
+#if defined(COMPACT_VERTICES) || defined(ATTRIBUTELESS_VERTICES)
+#ifdef COMPACT_VERTICES
+    ivec2 texel = ivec2(gl_VertexID % grid_size.x, gl_VertexID / grid_size.x);
+    float height = vertex_height;
+#else
+    int quad = gl_VertexID / 6;
+    ivec2 texel = ivec2(quad % (grid_size.x - 1), quad / (grid_size.x - 1)) + quad_corners[gl_VertexID % 6];
+    float height = texelFetch(height_map_sampler, texel, 0).r;
+#endif
+    vec2 grid_position = vec2(texel) - vec2(grid_size) / 2.0;
+    gl_Position = proj_view_transform * vec4(grid_position.x, height_scale * height, grid_position.y, 1.0);
+    tex_coordinates = vec2(texel) / vec2(grid_size);
+#else
     gl_Position = proj_view_transform * vec4(vertex_position, 1.0);
     tex_coordinates = vertex_tex_coordinates;
+#endif
 }
\ No newline at end of file
@@ -1,12 +1,34 @@
 #version 450 core
 
+#ifdef VERTEX_PULLING
+/*
+Attribute-less patches (see create_attributeless_grid_patch): the corners
+of the patches of a grid_size plane centered at the origin, split in
+patches x patches patches, are derived from gl_VertexID, in the order of
+grid_patch_vertices.
+*/
+uniform vec2 grid_size;
+uniform int patches;
+
+// (x, z) offsets of the 4 corners of a patch
+const ivec2 patch_corners[4] = ivec2[](ivec2(0, 1), ivec2(1, 1), ivec2(1, 0), ivec2(0, 0));
+#else
 layout (location = 0) in vec3 input_position;
 layout (location = 1) in vec2 input_tex_coordinates;
+#endif
 
 out vec2 vertex_tex_coordinates;
 
 void main()
 {
+#ifdef VERTEX_PULLING
+    int patch_index = gl_VertexID / 4;
+    ivec2 corner = ivec2(patch_index / patches, patch_index % patches) + patch_corners[gl_VertexID % 4];
+    vec2 position = vec2(corner) * grid_size / float(patches) - grid_size / 2.0;
+    gl_Position = vec4(position.x, 0.0, position.y, 1.0);
+    vertex_tex_coordinates = vec2(corner) / float(patches);
+#else
     gl_Position = vec4(input_position, 1.0);
     vertex_tex_coordinates = input_tex_coordinates;
+#endif
 }
\ No newline at end of file
@@ -1,7 +1,17 @@
 #version 450 core
 
+// Single-channel format of the height map (r16 or r32f), defined by the application
+#ifndef HEIGHTMAP_FORMAT
+#define HEIGHTMAP_FORMAT r32f
+#endif
+
+// Largest number of segments of the Hermite curve, defined by the application
+#ifndef MAX_CURVE_SEGMENTS
+#define MAX_CURVE_SEGMENTS 8
+#endif
+
 layout (local_size_x = 32, local_size_y = 32) in;
-layout (rgba8, binding = 0) uniform image2D heightmap;
+layout (HEIGHTMAP_FORMAT, binding = 0) uniform writeonly image2D heightmap;
 
 #include noise.glsl 
 
@@ -12,6 +22,27 @@ uniform float noise_scale;
 uniform float exponent;
 uniform vec2 offsets[16];
 
+// Hermite curve baked into segments (see CubicHermiteCurve::height_coefficients)
+uniform bool apply_hermite_curve;
+uniform int curve_segments;
+uniform float curve_ranges[MAX_CURVE_SEGMENTS + 1];
+uniform vec4 curve_coefficients[MAX_CURVE_SEGMENTS];
+
+float hermite_curve(float height)
+{
+    // The segment is the number of inner ranges reached by the height
+    int segment = 0;
+    for (int i = 1; i < curve_segments; i++)
+    {
+        segment += int(height >= curve_ranges[i]);
+    }
+
+    float start = curve_ranges[segment];
+    float s = (height - start) / (curve_ranges[segment + 1] - start);
+    vec4 c = curve_coefficients[segment];
+    return c.x + s * (c.y + s * (c.z + s * c.w));
+}
+
 float fbm(vec2 coordinate)
 {
     coordinate = coordinate * 2.0 - 1.0;
@@ -31,8 +62,12 @@ float fbm(vec2 coordinate)
         amplitude *= persistance;
     }
 
-    float height = value / weights;
-    return pow(height, exponent);
+    float height = pow(value / weights, exponent);
+    if (apply_hermite_curve)
+    {
+        height = hermite_curve(clamp(height, 0.0, 1.0));
+    }
+    return height;
 }
 
 void main()
@@ -40,6 +75,5 @@ void main()
     ivec2 texel_coord = ivec2(gl_GlobalInvocationID.xy);
     vec2 spatial_coordinate = gl_GlobalInvocationID.xy / 2048.0;
     float height = fbm(spatial_coordinate);
-    vec4 value = vec4(height);
-    imageStore(heightmap, texel_coord, value);
+    imageStore(heightmap, texel_coord, vec4(height, 0.0, 0.0, 1.0));
 }
\ No newline at end of file
@@ -1,9 +1,32 @@
 #version 450
 
+// Single-channel format of the height map (r16 or r32f), defined by the application
+#ifndef HEIGHTMAP_FORMAT
+#define HEIGHTMAP_FORMAT r32f
+#endif
+
+// Format of the normal map, defined by the application along with OCTAHEDRAL_NORMALS for rg8 or rg16
+#ifndef NORMALMAP_FORMAT
+#define NORMALMAP_FORMAT rgba8
+#endif
+
 layout (local_size_x = 32, local_size_y = 32) in;
 
-layout (binding=0, rgba8) uniform image2D heightmap;
-layout (binding=1, rgba8) uniform image2D normalmap;
+layout (binding=0, HEIGHTMAP_FORMAT) readonly uniform image2D heightmap;
+layout (binding=1, NORMALMAP_FORMAT) writeonly uniform image2D normalmap;
+
+#ifdef OCTAHEDRAL_NORMALS
+// Map a unit vector onto the [-1, 1]^2 square, folding the lower hemisphere over the diagonals
+vec2 octahedral_encode(vec3 normal)
+{
+    vec2 projected = normal.xy / (abs(normal.x) + abs(normal.y) + abs(normal.z));
+    if (normal.z < 0.0)
+    {
+        projected = (1.0 - abs(projected.yx)) * vec2(projected.x >= 0.0 ? 1.0 : -1.0, projected.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return projected;
+}
+#endif
 
 shared float local_neighborhood[gl_WorkGroupSize.x+2][gl_WorkGroupSize.y+2];
 
@@ -23,8 +46,13 @@ void sobel_operator()
     float dx = (top_right + 2 * center_right + bottom_right) - (top_left + 2 * center_left + bottom_left);
     float dy = (bottom_left + 2 * bottom + bottom_right)  - (top_left + 2 * top + top_right);
     vec3 normal = normalize(vec3(dx, dy, 0.1));
+#ifdef OCTAHEDRAL_NORMALS
+    vec2 rg_normal = (octahedral_encode(normal) + 1.0) / 2.0;
+    imageStore(normalmap, ivec2(gl_GlobalInvocationID.xy), vec4(rg_normal, 0.0, 1.0));
+#else
     vec3 rgb_normal = (normal + 1.0) / 2.0;
     imageStore(normalmap, ivec2(gl_GlobalInvocationID.xy), vec4(rgb_normal, 1.0));
+#endif
 }
 
 void main()
@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gridmesh.hpp"
+#include "hermite.hpp"
+#include "image.hpp"
+#include "mapfile.hpp"
+#include "minmaxpyramid.hpp"
+#include "noisegeneration.hpp"
+#include "parallel.hpp"
+
+/*
+Micro-benchmarks of the CPU hot paths at square resolutions from 256 to
+8192 (powers of two) and, for the multithreaded ones, 1, 2, 4, ...
+workers up to the number of hardware threads. Every case reports the
+best of several runs as CSV:
+
+- elements: number of texels (or vertices, or curve samples) per run;
+- ns_per_element: best run time divided by elements;
+- bytes_per_second: bytes read and written by one run (estimated from
+  the size of the inputs and outputs) divided by the best run time;
+- allocations: heap allocations made by one run, counted by replacing
+  the global operator new.
+
+Options: --min-size N, --max-size N, --repetitions N and --workers N
+(largest worker count, 0 for all hardware threads).
+*/
+namespace
+{
+
+std::atomic<std::uint64_t> allocation_count{0};
+
+void* allocate(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded_size{(std::max<std::size_t>(size, 1) + align - 1) / align * align};
+#ifdef _MSC_VER
+    void* pointer = _aligned_malloc(rounded_size, align);
+#else
+    void* pointer = std::aligned_alloc(align, rounded_size);
+#endif
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+
+void deallocate_aligned(void* pointer)
+{
+#ifdef _MSC_VER
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+struct Options
+{
+    std::size_t min_size{256};
+    std::size_t max_size{8192};
+    int repetitions{3};
+    std::size_t max_workers{0};
+};
+
+Options parse_options(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view option{argv[i]};
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value for " + std::string{option});
+        }
+        const auto value = static_cast<std::size_t>(std::stoull(argv[++i]));
+        if (option == "--min-size")
+        {
+            options.min_size = value;
+        }
+        else if (option == "--max-size")
+        {
+            options.max_size = value;
+        }
+        else if (option == "--repetitions")
+        {
+            options.repetitions = static_cast<int>(std::max<std::size_t>(value, 1));
+        }
+        else if (option == "--workers")
+        {
+            options.max_workers = value;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + std::string{option});
+        }
+    }
+    if (options.min_size < 2 || options.max_size < options.min_size)
+    {
+        throw std::invalid_argument("Invalid size range");
+    }
+    return options;
+}
+
+struct Measurement
+{
+    double seconds{std::numeric_limits<double>::max()};
+    std::uint64_t allocations{0};
+};
+
+/*
+Best time of several runs of function. Setup runs before each run, out of
+the timed section, so runs that consume their input start from the same
+state. Allocations are those of the last run.
+*/
+template<typename Setup, typename Function>
+Measurement measure(int repetitions, Setup&& setup, Function&& function)
+{
+    Measurement measurement;
+    for (int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        setup();
+        const std::uint64_t allocations_before{allocation_count.load(std::memory_order_relaxed)};
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        measurement.allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+        measurement.seconds = std::min(measurement.seconds, elapsed.count());
+    }
+    return measurement;
+}
+
+template<typename Function>
+Measurement measure(int repetitions, Function&& function)
+{
+    return measure(repetitions, [] {}, std::forward<Function>(function));
+}
+
+void report(std::string_view benchmark, std::size_t size, std::size_t workers, std::string_view unit,
+            std::uint64_t elements, double bytes, const Measurement& measurement)
+{
+    std::cout << benchmark << ',' << size << ',' << workers << ',' << unit << ',' << elements << ','
+              << measurement.seconds << ',' << measurement.seconds * 1e9 / static_cast<double>(elements) << ','
+              << bytes / measurement.seconds << ',' << measurement.allocations << std::endl;
+}
+
+// Keeps the optimizer from discarding results that are otherwise unused
+const void* volatile result_sink{nullptr};
+
+template<typename T>
+void keep(const T& value)
+{
+    result_sink = &value;
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n'
+                  << "Usage: cpu-benchmark [--min-size N] [--max-size N] [--repetitions N] [--workers N]\n";
+        return 1;
+    }
+
+    const std::size_t max_workers{options.max_workers == 0 ? hardware_workers() : options.max_workers};
+    std::vector<std::size_t> worker_counts;
+    for (std::size_t workers = 1; workers < max_workers; workers *= 2)
+    {
+        worker_counts.push_back(workers);
+    }
+    worker_counts.push_back(max_workers);
+
+    const int repetitions{options.repetitions};
+    std::cout << "benchmark,size,workers,unit,elements,seconds,ns_per_element,bytes_per_second,allocations\n";
+    for (std::size_t size = options.min_size; size <= options.max_size; size *= 2)
+    {
+        const std::uint64_t texels{static_cast<std::uint64_t>(size) * size};
+        const auto dimension = static_cast<std::uint32_t>(size);
+
+        {
+            FractalNoiseGenerator generator{dimension, dimension};
+            for (const std::size_t workers : worker_counts)
+            {
+                generator.set_workers(workers);
+                // Writes the raw and the redistributed height maps
+                report("update_height_map", size, workers, "texel", texels, 8.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] { generator.update_height_map(); }));
+                // Reads the height map and writes an RGBA8 normal map
+                report("update_normal_map", size, workers, "texel", texels, 8.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] { generator.update_normal_map(); }));
+            }
+
+            const Image<float>& height_map = generator.height_map();
+            Image<float> normalized{size, size};
+            const Image<std::uint8_t>& normal_map = generator.normal_map();
+            Image<std::uint8_t> packed_normals{size, size, 2};
+            for (const std::size_t workers : worker_counts)
+            {
+                report("min_max", size, workers, "texel", texels, 4.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] { keep(min_max(height_map, workers)); }));
+                // Reads the map once for the range and once more to normalize it in place
+                report("normalize_image", size, workers, "texel", texels, 12.0 * static_cast<double>(texels),
+                       measure(
+                           repetitions, [&] { normalized = height_map; },
+                           [&] { normalize_image(normalized, workers); }));
+                report("from_float_to_uint8", size, workers, "texel", texels, 5.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] { keep(from_float_to_uint8(height_map, workers)); }));
+                report("from_float_to_half", size, workers, "texel", texels, 6.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] { keep(from_float_to_half(height_map, workers)); }));
+                // Packs the RGBA normal map into two channels
+                report("convert_channels", size, workers, "texel", texels, 6.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] {
+                           convert_channels(normal_map.view(), packed_normals.mutable_view(), std::uint8_t{0},
+                                            workers);
+                       }));
+            }
+
+            // Reads the height map and writes 2 floats per 2x2 texels (and a third as much for the upper levels)
+            for (const std::size_t workers : worker_counts)
+            {
+                report("min_max_pyramid", size, workers, "texel", texels, 4.7 * static_cast<double>(texels),
+                       measure(repetitions, [&] { keep(MinMaxPyramid{height_map, workers}); }));
+            }
+            MinMaxPyramid pyramid{height_map};
+            // A 64x64 edit in the middle of the map
+            constexpr std::size_t edit_size{64};
+            const std::size_t edit_start{(size - std::min(size, edit_size)) / 2};
+            const std::size_t edit_texels{std::min(size, edit_size) * std::min(size, edit_size)};
+            report("min_max_pyramid_update", size, 1, "texel", edit_texels, 4.0 * static_cast<double>(edit_texels),
+                   measure(repetitions, [&] {
+                       pyramid.update(height_map, edit_start, edit_start, std::min(size, edit_size),
+                                      std::min(size, edit_size));
+                   }));
+            // Regions of every size, one per diagonal position
+            report("min_max_pyramid_bounds", size, 1, "query", size, 0.0, measure(repetitions, [&] {
+                       float sum{0.0f};
+                       for (std::size_t i = 0; i < size; ++i)
+                       {
+                           const auto [low, high] = pyramid.bounds(i / 2, i / 3, size - i, size - i / 3);
+                           sum += high - low;
+                       }
+                       keep(sum);
+                   }));
+
+            // Map files in the temporary directory: one of uncompressed chunks and one of compressed chunks
+            const std::filesystem::path raw_maps{std::filesystem::temp_directory_path() / "cpu-benchmark-raw.tmap"};
+            const std::filesystem::path compressed_maps{std::filesystem::temp_directory_path() /
+                                                        "cpu-benchmark-compressed.tmap"};
+            {
+                MapFileWriter writer{raw_maps};
+                writer.add_map("height", height_map.view());
+                writer.finish();
+            }
+            report("map_file_write_compressed", size, 1, "texel", texels, 8.0 * static_cast<double>(texels),
+                   measure(repetitions, [&] {
+                       MapFileWriter writer{compressed_maps};
+                       writer.add_map("height", height_map.view(), 256, ChunkCompression::delta_rle);
+                       writer.finish();
+                   }));
+            // Opening parses the directory only; the views of the chunks point into the mapping
+            report("map_file_open", size, 1, "texel", texels, 0.0, measure(repetitions, [&] {
+                       const MapFile map_file{raw_maps};
+                       const MapInfo& info = map_file.maps()[0];
+                       for (std::size_t chunk_row = 0; chunk_row < info.chunk_rows(); ++chunk_row)
+                       {
+                           for (std::size_t chunk_column = 0; chunk_column < info.chunk_columns(); ++chunk_column)
+                           {
+                               keep(map_file.chunk_view<float>(0, chunk_row, chunk_column));
+                           }
+                       }
+                   }));
+            {
+                const MapFile map_file{compressed_maps};
+                for (const std::size_t workers : worker_counts)
+                {
+                    report("map_file_read_compressed", size, workers, "texel", texels,
+                           8.0 * static_cast<double>(texels),
+                           measure(repetitions, [&] { keep(map_file.read_map<float>(0, workers)); }));
+                }
+            }
+            std::filesystem::remove(raw_maps);
+            std::filesystem::remove(compressed_maps);
+
+            // Reads a height per vertex and writes 5 floats per vertex and 6 indices per quad
+            const CubicHermiteCurve& curve = generator.curve();
+            const int grid_size{static_cast<int>(size)};
+            std::vector<float> mesh_vertices(grid_mesh_vertex_values(grid_size, grid_size));
+            std::vector<std::uint32_t> mesh_indices(grid_mesh_index_count(grid_size, grid_size));
+            std::vector<std::uint16_t> compact_heights(texels);
+            for (const std::size_t workers : worker_counts)
+            {
+                report("grid_mesh", size, workers, "vertex", texels, 48.0 * static_cast<double>(texels),
+                       measure(repetitions,
+                               [&] { keep(grid_mesh(grid_size, grid_size, height_map, curve, workers)); }));
+                // Same, into preallocated buffers (as when writing to a mapped vertex buffer)
+                report("build_grid_mesh", size, workers, "vertex", texels, 48.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] {
+                           build_grid_mesh(grid_size, grid_size, height_map, curve, mesh_vertices, mesh_indices,
+                                           workers);
+                       }));
+                // Compact vertices for vertex pulling: a 16-bit height per vertex
+                report("build_grid_heights", size, workers, "vertex", texels, 6.0 * static_cast<double>(texels),
+                       measure(repetitions, [&] {
+                           build_grid_heights(grid_size, grid_size, height_map, curve, compact_heights, workers);
+                       }));
+            }
+
+            // Samples spread over [0, 1], written as the 2 coordinates of the curve
+            std::vector<float> parameters(texels);
+            for (std::size_t i = 0; i < parameters.size(); ++i)
+            {
+                parameters[i] = static_cast<float>(i) / static_cast<float>(parameters.size() - 1);
+            }
+            std::vector<glm::vec2> curve_points(texels);
+            report("hermite_evaluate", size, 1, "sample", texels, 12.0 * static_cast<double>(texels),
+                   measure(repetitions, [&] {
+                       std::transform(parameters.begin(), parameters.end(), curve_points.begin(),
+                                      [&curve](float parameter) { return curve.evaluate(parameter); });
+                       keep(curve_points);
+                   }));
+        }
+
+        // One patch per 8x8 texels of the map; each patch has 4 vertices of 5 floats
+        const int patches{static_cast<int>(size / 8)};
+        const std::uint64_t patch_vertices{4 * static_cast<std::uint64_t>(patches) * patches};
+        report("grid_patch_vertices", size, 1, "vertex", patch_vertices, 20.0 * static_cast<double>(patch_vertices),
+               measure(repetitions, [&] {
+                   keep(grid_patch_vertices(static_cast<int>(size), static_cast<int>(size), patches));
+               }));
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "erosion.hpp"
+#include "gradientnoise.hpp"
+#include "image.hpp"
+#include "parallel.hpp"
+
+/*
+Measures the throughput of the hydraulic erosion, in droplets per
+second, then the time of 100 thermal erosion iterations, for 1, 2, 4,
+... workers up to the number of hardware threads. Every run starts from
+the same 2048x2048 fBm height map and its result is compared with the
+single-worker run to check determinism.
+*/
+namespace
+{
+
+constexpr std::size_t size{2048};
+constexpr std::uint32_t droplets{1000000};
+constexpr std::uint32_t thermal_iterations{100};
+
+Image<float> make_height_map()
+{
+    std::vector<glm::vec2> offsets;
+    for (std::uint32_t octave = 0; octave < 8; ++octave)
+    {
+        offsets.push_back(octave_offset(0, octave));
+    }
+
+    Image<float> height_map{size, size};
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        fractal_noise_row(std::span<float>{height_map.data() + i * size, size},
+                          glm::vec2{0.0f, static_cast<float>(i)}, 1.0f, offsets, 500.0f, 2.0f, 0.5f);
+    }
+    const float min_height{height_map.min()};
+    const float max_height{height_map.max()};
+    height_map.transform([=](float height) { return (height - min_height) / (max_height - min_height); });
+    return height_map;
+}
+
+} // namespace
+
+int main()
+{
+    const Image<float> height_map = make_height_map();
+    HydraulicErosionSettings settings{};
+    settings.droplets = droplets;
+
+    std::vector<std::size_t> worker_counts;
+    for (std::size_t workers = 1; workers < hardware_workers(); workers *= 2)
+    {
+        worker_counts.push_back(workers);
+    }
+    worker_counts.push_back(hardware_workers());
+
+    Image<float> reference{size, size};
+    std::cout << "workers,droplets,seconds,droplets_per_second,identical\n";
+    for (const std::size_t workers : worker_counts)
+    {
+        Image<float> eroded = height_map;
+        const auto start = std::chrono::steady_clock::now();
+        erode_hydraulic(eroded, settings, workers);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (workers == 1)
+        {
+            reference = eroded;
+        }
+        const bool identical = std::memcmp(eroded.data(), reference.data(), eroded.pixels() * sizeof(float)) == 0;
+        std::cout << workers << ',' << droplets << ',' << elapsed.count() << ','
+                  << static_cast<double>(droplets) / elapsed.count() << ',' << (identical ? "yes" : "no") << '\n';
+    }
+
+    // No tolerance, so every run performs all the iterations
+    ThermalErosionSettings thermal_settings{};
+    thermal_settings.iterations = thermal_iterations;
+    thermal_settings.tolerance = 0.0f;
+
+    std::cout << "\nworkers,iterations,seconds,iterations_per_second,identical\n";
+    for (const std::size_t workers : worker_counts)
+    {
+        Image<float> eroded = height_map;
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint32_t iterations = erode_thermal(eroded, thermal_settings, workers);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (workers == 1)
+        {
+            reference = eroded;
+        }
+        const bool identical = std::memcmp(eroded.data(), reference.data(), eroded.pixels() * sizeof(float)) == 0;
+        std::cout << workers << ',' << iterations << ',' << elapsed.count() << ','
+                  << static_cast<double>(iterations) / elapsed.count() << ',' << (identical ? "yes" : "no") << '\n';
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "image.hpp"
+#include "random.hpp"
+#include "tiledimage.hpp"
+
+/*
+Compares the row-major layout of Image with the blocked layout of
+TiledImage on the 2D access patterns of the CPU passes, through the same
+get API:
+
+- stencil_rows: 3x3 Sobel stencil over every texel, row by row;
+- stencil_columns: the same stencil, column by column;
+- random_walks: bilinear samples along short random walks, as made by
+  the erosion droplets.
+
+It also measures to_tiled and to_row_major. Every case reports the best
+of several runs as CSV, with the L1 data cache, last level cache and
+data TLB misses per texel read from the hardware counters of that run
+(Linux only; -1 when the counters are unavailable, e.g. in containers
+without perf access).
+
+Options: --min-size N, --max-size N and --repetitions N.
+*/
+namespace
+{
+
+struct Options
+{
+    std::size_t min_size{1024};
+    std::size_t max_size{8192};
+    int repetitions{3};
+};
+
+Options parse_options(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view option{argv[i]};
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value for " + std::string{option});
+        }
+        const auto value = static_cast<std::size_t>(std::stoull(argv[++i]));
+        if (option == "--min-size")
+        {
+            options.min_size = value;
+        }
+        else if (option == "--max-size")
+        {
+            options.max_size = value;
+        }
+        else if (option == "--repetitions")
+        {
+            options.repetitions = static_cast<int>(std::max<std::size_t>(value, 1));
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + std::string{option});
+        }
+    }
+    if (options.min_size < 3 || options.max_size < options.min_size)
+    {
+        throw std::invalid_argument("Invalid size range");
+    }
+    return options;
+}
+
+constexpr std::size_t counter_count{3};
+using CounterValues = std::array<std::int64_t, counter_count>;
+
+/*
+L1 data cache read misses, last level cache misses and data TLB read
+misses of the calling thread, counted in user space only.
+*/
+class HardwareCounters
+{
+public:
+    HardwareCounters()
+    {
+#ifdef __linux__
+        constexpr std::uint64_t read_miss{(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        const std::array<std::pair<std::uint32_t, std::uint64_t>, counter_count> events{{
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read_miss},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read_miss},
+        }};
+        for (std::size_t counter = 0; counter < counter_count; ++counter)
+        {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = events[counter].first;
+            attributes.config = events[counter].second;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptors_[counter] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    ~HardwareCounters()
+    {
+#ifdef __linux__
+        for (const int descriptor : descriptors_)
+        {
+            if (descriptor != -1)
+            {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (const int descriptor : descriptors_)
+        {
+            if (descriptor != -1)
+            {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Counts since start, -1 for the counters that couldn't be opened
+    CounterValues stop()
+    {
+        CounterValues values;
+        values.fill(-1);
+#ifdef __linux__
+        for (std::size_t counter = 0; counter < counter_count; ++counter)
+        {
+            const int descriptor{descriptors_[counter]};
+            std::uint64_t value{0};
+            if (descriptor != -1)
+            {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(descriptor, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value)))
+                {
+                    values[counter] = static_cast<std::int64_t>(value);
+                }
+            }
+        }
+#endif
+        return values;
+    }
+
+private:
+    std::array<int, counter_count> descriptors_{-1, -1, -1};
+};
+
+struct Measurement
+{
+    double seconds{std::numeric_limits<double>::max()};
+    CounterValues counters{-1, -1, -1};
+};
+
+template<typename Function>
+Measurement measure(int repetitions, HardwareCounters& counters, Function&& function)
+{
+    Measurement measurement;
+    for (int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        counters.start();
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const CounterValues values = counters.stop();
+        if (elapsed.count() < measurement.seconds)
+        {
+            measurement.seconds = elapsed.count();
+            measurement.counters = values;
+        }
+    }
+    return measurement;
+}
+
+void report(std::string_view benchmark, std::string_view layout, std::size_t size, const Measurement& measurement)
+{
+    const auto texels = static_cast<double>(size * size);
+    std::cout << benchmark << ',' << layout << ',' << size << ',' << measurement.seconds << ','
+              << measurement.seconds * 1e9 / texels;
+    for (const std::int64_t count : measurement.counters)
+    {
+        std::cout << ',' << (count < 0 ? -1.0 : static_cast<double>(count) / texels);
+    }
+    std::cout << std::endl;
+}
+
+// Keeps the optimizer from discarding results that are otherwise unused
+volatile float result_sink{0.0f};
+
+template<typename Map>
+float sobel(const Map& map, std::size_t i, std::size_t j)
+{
+    const float dx = (map.get(i - 1, j + 1) + 2 * map.get(i, j + 1) + map.get(i + 1, j + 1)) -
+                     (map.get(i - 1, j - 1) + 2 * map.get(i, j - 1) + map.get(i + 1, j - 1));
+    const float dy = (map.get(i + 1, j - 1) + 2 * map.get(i + 1, j) + map.get(i + 1, j + 1)) -
+                     (map.get(i - 1, j - 1) + 2 * map.get(i - 1, j) + map.get(i - 1, j + 1));
+    return dx * dx + dy * dy;
+}
+
+template<typename Map>
+void stencil_rows(const Map& map)
+{
+    float sum{0.0f};
+    for (std::size_t i = 1; i + 1 < map.height(); ++i)
+    {
+        for (std::size_t j = 1; j + 1 < map.width(); ++j)
+        {
+            sum += sobel(map, i, j);
+        }
+    }
+    result_sink = sum;
+}
+
+template<typename Map>
+void stencil_columns(const Map& map)
+{
+    float sum{0.0f};
+    for (std::size_t j = 1; j + 1 < map.width(); ++j)
+    {
+        for (std::size_t i = 1; i + 1 < map.height(); ++i)
+        {
+            sum += sobel(map, i, j);
+        }
+    }
+    result_sink = sum;
+}
+
+template<typename Map>
+float bilinear(const Map& map, float x, float y)
+{
+    const auto j = static_cast<std::size_t>(x);
+    const auto i = static_cast<std::size_t>(y);
+    const float u{x - static_cast<float>(j)};
+    const float v{y - static_cast<float>(i)};
+    const float top{map.get(i, j) + u * (map.get(i, j + 1) - map.get(i, j))};
+    const float bottom{map.get(i + 1, j) + u * (map.get(i + 1, j + 1) - map.get(i + 1, j))};
+    return top + v * (bottom - top);
+}
+
+// One bilinear sample per texel on average, along walks of unit steps in random directions
+template<typename Map>
+void random_walks(const Map& map)
+{
+    constexpr std::uint64_t steps{64};
+    const std::uint64_t walks{map.width() * map.height() / steps};
+    const float limit_x{static_cast<float>(map.width() - 2)};
+    const float limit_y{static_cast<float>(map.height() - 2)};
+    float sum{0.0f};
+    for (std::uint64_t walk = 0; walk < walks; ++walk)
+    {
+        float x{random_float(0, walk, 0, 0.0f, limit_x)};
+        float y{random_float(0, walk, 1, 0.0f, limit_y)};
+        for (std::uint64_t step = 0; step < steps; ++step)
+        {
+            sum += bilinear(map, x, y);
+            x = std::clamp(x + random_float(0, walk, 2 + 2 * step, -1.0f, 1.0f), 0.0f, limit_x);
+            y = std::clamp(y + random_float(0, walk, 3 + 2 * step, -1.0f, 1.0f), 0.0f, limit_y);
+        }
+    }
+    result_sink = sum;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n'
+                  << "Usage: layout-benchmark [--min-size N] [--max-size N] [--repetitions N]\n";
+        return 1;
+    }
+
+    HardwareCounters counters;
+    const int repetitions{options.repetitions};
+    std::cout << "benchmark,layout,size,seconds,ns_per_texel,l1d_misses_per_texel,llc_misses_per_texel,"
+                 "dtlb_misses_per_texel\n";
+    for (std::size_t size = options.min_size; size <= options.max_size; size *= 2)
+    {
+        Image<float> row_major{size, size};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            for (std::size_t j = 0; j < size; ++j)
+            {
+                row_major.set(i, j, 0, random_float(1, i, j));
+            }
+        }
+        const TiledImage<float> tiled = to_tiled(row_major.view());
+
+        report("stencil_rows", "row_major", size, measure(repetitions, counters, [&] { stencil_rows(row_major); }));
+        report("stencil_rows", "tiled", size, measure(repetitions, counters, [&] { stencil_rows(tiled); }));
+        report("stencil_columns", "row_major", size,
+               measure(repetitions, counters, [&] { stencil_columns(row_major); }));
+        report("stencil_columns", "tiled", size, measure(repetitions, counters, [&] { stencil_columns(tiled); }));
+        report("random_walks", "row_major", size, measure(repetitions, counters, [&] { random_walks(row_major); }));
+        report("random_walks", "tiled", size, measure(repetitions, counters, [&] { random_walks(tiled); }));
+
+        report("to_tiled", "tiled", size, measure(repetitions, counters, [&] {
+                   const TiledImage<float> converted = to_tiled(row_major.view());
+                   result_sink = converted.get(size - 1, size - 1);
+               }));
+        report("to_row_major", "row_major", size, measure(repetitions, counters, [&] {
+                   const Image<float> converted = to_row_major(tiled);
+                   result_sink = converted.get(size - 1, size - 1);
+               }));
+    }
+
+    return 0;
+}
\ No newline at end of file
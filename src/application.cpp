@@ -11,19 +11,63 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cassert>
+#include <cstring>
 #include <ctime>
 #include <iostream>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "framebuffer.hpp"
+#include "hermite.hpp"
 #include "mesh.hpp"
 #include "meshgeneration.hpp"
 #include "shader.hpp"
 #include "skybox.hpp"
+#include "terraincache.hpp"
 #include "texture.hpp"
 #include "water.hpp"
 
+namespace
+{
+
+// Single-channel height map format: GL_R16 (16-bit unsigned normalized) or GL_R32F
+constexpr GLenum height_map_format{GL_R16};
+
+// Normal map format: GL_RGBA8 for plain normals, GL_RG8 or GL_RG16 for octahedral ones (see normalencoding.hpp)
+constexpr GLenum normal_map_format{GL_RG8};
+constexpr bool octahedral_normals{normal_map_format != GL_RGBA8};
+constexpr NormalEncoding normal_encoding{octahedral_normals ? NormalEncoding::octahedral : NormalEncoding::rgba};
+constexpr std::size_t normal_map_channels{octahedral_normals ? 2 : 4};
+
+// Patches per side of the tessellated terrain
+constexpr int terrain_patches{64};
+
+// Largest number of Hermite curve segments the height map shader accepts
+constexpr std::size_t max_curve_segments{8};
+
+// Memory kept for terrain maps already generated in the editor, about ten 2048x2048 terrains. The
+// cache stores 8-bit normals, so it's only used when the normal map has 8-bit channels.
+constexpr std::size_t terrain_cache_capacity{256 * 1024 * 1024};
+
+} // namespace
+
+/*
+Terrain maps being copied from their textures into a pixel pack buffer.
+They are stored in the terrain cache once the fence is signaled, so the
+editor never waits for the copy.
+*/
+struct TerrainReadback
+{
+    std::uint32_t buffer{0};
+    GLsync fence{nullptr};
+    std::uint64_t key{0};
+    std::size_t height_map_size{0};
+    std::size_t normal_map_size{0};
+};
+
 Application::Application(int window_width, int window_height, std::string_view title) :
     width_{window_width}, height_{window_height}, aspect_ratio_{static_cast<float>(width_) / height_}
 {
@@ -219,24 +263,51 @@ void Application::initialize_imgui()
 
 void Application::initialize_terrain()
 {
-    terrain_mesh_ = create_grid_patch(grid_mesh_dim_.first, grid_mesh_dim_.second, 64);
-
+    // The patches have no vertex data; the vertex shader derives their corners from the grid size
+    terrain_mesh_ = create_attributeless_grid_patch(terrain_patches);
+
+    const std::string height_map_definitions{"#define HEIGHTMAP_FORMAT " +
+                                             std::string{image_format_qualifier(height_map_format)}};
+    const std::string curve_definitions{"#define MAX_CURVE_SEGMENTS " + std::to_string(max_curve_segments)};
+    // The shaders decode octahedral normals only when told so; both the generator and the terrain use the define
+    const std::string octahedral_definitions{octahedral_normals ? "#define OCTAHEDRAL_NORMALS\n" : ""};
+    const std::string normal_map_definitions{octahedral_definitions + "#define NORMALMAP_FORMAT " +
+                                             std::string{image_format_qualifier(normal_map_format)}};
     heightmap_generator_ =
         std::make_unique<ShaderProgram>(std::initializer_list<std::pair<std::string_view, Shader::Type>>{
-            {"assets/shaders/heightmap/heightmap.glsl", Shader::Type::Compute},
-        });
+                                            {"assets/shaders/heightmap/heightmap.glsl", Shader::Type::Compute},
+                                        },
+                                        height_map_definitions + "\n" + curve_definitions);
     heightmap_generator_->set_float_uniform("lacunarity", fractal_noise_generator_.noise_settings.lacunarity);
     heightmap_generator_->set_float_uniform("persistance", fractal_noise_generator_.noise_settings.persistance);
     heightmap_generator_->set_int_uniform("octaves", fractal_noise_generator_.noise_settings.octaves);
     heightmap_generator_->set_float_uniform("noise_scale", fractal_noise_generator_.noise_settings.noise_scale);
     heightmap_generator_->set_float_uniform("exponent", fractal_noise_generator_.noise_settings.exponent);
 
-    terrain_heightmap_ = std::make_unique<Texture>(height_map_dim_.first, height_map_dim_.second);
+    terrain_heightmap_ = std::make_unique<Texture>(height_map_dim_.first, height_map_dim_.second,
+                                                   single_channel_attributes(height_map_format));
     normalmap_generator_ =
         std::make_unique<ShaderProgram>(std::initializer_list<std::pair<std::string_view, Shader::Type>>{
-            {"assets/shaders/heightmap/normalmap.glsl", Shader::Type::Compute},
-        });
-    terrain_normalmap_ = std::make_unique<Texture>(height_map_dim_.first, height_map_dim_.second);
+                                            {"assets/shaders/heightmap/normalmap.glsl", Shader::Type::Compute},
+                                        },
+                                        height_map_definitions + "\n" + normal_map_definitions);
+    terrain_normalmap_ = std::make_unique<Texture>(
+        height_map_dim_.first, height_map_dim_.second,
+        octahedral_normals ? two_channel_attributes(normal_map_format) : Texture::Attributes{});
+    if (normal_map_format != GL_RG16)
+    {
+        terrain_cache_ = std::make_shared<TerrainCache>(terrain_cache_capacity);
+
+        const std::size_t texels{std::size_t{height_map_dim_.first} * height_map_dim_.second};
+        terrain_readback_ = std::make_unique<TerrainReadback>();
+        terrain_readback_->height_map_size = texels * sizeof(float);
+        terrain_readback_->normal_map_size = texels * normal_map_channels;
+        glCreateBuffers(1, &terrain_readback_->buffer);
+        glNamedBufferStorage(terrain_readback_->buffer,
+                             static_cast<GLsizeiptr>(terrain_readback_->height_map_size +
+                                                     terrain_readback_->normal_map_size),
+                             nullptr, GL_MAP_READ_BIT);
+    }
     compute_terrain_maps();
 
     // Terrain textures attributes
@@ -274,12 +345,18 @@ void Application::initialize_terrain()
     };
     terrain_ao_maps_ = std::make_unique<Texture>(create_arraytexture_from_file(ao_names, ambient_occlusion_attributes));
 
-    terrain_program_ = std::make_unique<ShaderProgram>(std::initializer_list<std::pair<std::string_view, Shader::Type>>{
-        {"assets/shaders/gpu_terrain/vertex_shader.vs", Shader::Type::Vertex},
-        {"assets/shaders/gpu_terrain/tess_control_shader.tcs", Shader::Type::TessControl},
-        {"assets/shaders/gpu_terrain/tess_eval_shader.tes", Shader::Type::TessEval},
-        {"assets/shaders/gpu_terrain/fragment_shader.fs", Shader::Type::Fragment},
-    });
+    terrain_program_ = std::make_unique<ShaderProgram>(
+        std::initializer_list<std::pair<std::string_view, Shader::Type>>{
+            {"assets/shaders/gpu_terrain/vertex_shader.vs", Shader::Type::Vertex},
+            {"assets/shaders/gpu_terrain/tess_control_shader.tcs", Shader::Type::TessControl},
+            {"assets/shaders/gpu_terrain/tess_eval_shader.tes", Shader::Type::TessEval},
+            {"assets/shaders/gpu_terrain/fragment_shader.fs", Shader::Type::Fragment},
+        },
+        octahedral_definitions + "#define VERTEX_PULLING");
+
+    terrain_program_->set_vec2_uniform("grid_size", static_cast<float>(grid_mesh_dim_.first),
+                                       static_cast<float>(grid_mesh_dim_.second));
+    terrain_program_->set_int_uniform("patches", terrain_patches);
 
     terrain_program_->set_float_uniform("elevation", terrain_elevation_);
     terrain_program_->set_float_array_uniform("triplanar_scale[0]", textures_scale_.data(),
@@ -314,6 +391,12 @@ Application::~Application()
 
 void Application::cleanup()
 {
+    if (terrain_readback_)
+    {
+        glDeleteSync(terrain_readback_->fence);
+        glDeleteBuffers(1, &terrain_readback_->buffer);
+        terrain_readback_.reset();
+    }
     skybox_.reset();
     water_.reset();
     terrain_program_.reset();
@@ -398,6 +481,7 @@ void Application::update(float delta_time)
     }
 
     water_->update(delta_time);
+    collect_terrain_readback();
 }
 
 void Application::render()
@@ -495,23 +579,25 @@ void Application::render_imgui_editor()
         {
             compute_terrain_maps();
         }
+        if (ImGui::Checkbox("Hermite Curve Redistribution", &apply_hermite_curve_))
+        {
+            compute_terrain_maps();
+        }
         if (ImGui::SliderInt("Seed", &fractal_noise_generator_.noise_settings.seed, -1, 100))
         {
             if (fractal_noise_generator_.noise_settings.seed == -1)
             {
-                std::srand(std::time(nullptr));
+                fractal_noise_generator_.generate_random_offsets(static_cast<std::uint64_t>(std::time(nullptr)));
             }
             else
             {
-                std::srand(fractal_noise_generator_.noise_settings.seed);
+                fractal_noise_generator_.generate_random_offsets();
             }
-            fractal_noise_generator_.generate_random_offsets();
             compute_terrain_maps();
         }
         ImGui::Text("(Note: Set seed = -1 to use current time as seed)");
         if (ImGui::SliderFloat2("Offset", glm::value_ptr(fractal_noise_generator_.noise_settings.offset), -1000, 1000))
         {
-            fractal_noise_generator_.generate_random_offsets();
             compute_terrain_maps();
         }
 
@@ -631,6 +717,23 @@ void Application::render_imgui_editor()
 
 void Application::compute_terrain_maps()
 {
+    // Sliders such as the number of octaves change the settings only; derive the offsets of every octave first
+    fractal_noise_generator_.generate_random_offsets(fractal_noise_generator_.seed());
+    assert(fractal_noise_generator_.random_offsets().size() >=
+           static_cast<std::size_t>(fractal_noise_generator_.noise_settings.octaves));
+
+    // Settings revisited while scrubbing the editor's sliders are uploaded from the cache instead of regenerated
+    const std::span<const glm::vec2> offsets{fractal_noise_generator_.random_offsets().data(),
+                                             static_cast<std::size_t>(fractal_noise_generator_.noise_settings.octaves)};
+    const std::uint64_t key{terrain_hash(fractal_noise_generator_.noise_settings, offsets, height_map_dim_.first,
+                                         height_map_dim_.second, apply_hermite_curve_, normal_encoding)};
+    if (const auto maps = terrain_cache_ ? terrain_cache_->find(key) : nullptr)
+    {
+        terrain_heightmap_->copy_image(maps->height_map.view());
+        terrain_normalmap_->copy_image(maps->normal_map.view());
+        return;
+    }
+
     terrain_heightmap_->bind_image(0);
     heightmap_generator_->use();
     heightmap_generator_->set_float_uniform("lacunarity", fractal_noise_generator_.noise_settings.lacunarity);
@@ -640,6 +743,21 @@ void Application::compute_terrain_maps()
     heightmap_generator_->set_float_uniform("exponent", fractal_noise_generator_.noise_settings.exponent);
     heightmap_generator_->set_vec2_array_uniform("offsets[0]", fractal_noise_generator_.random_offsets(),
                                                  fractal_noise_generator_.noise_settings.octaves);
+
+    // The Hermite curve is applied in the same dispatch from its baked segments
+    const CubicHermiteCurve& curve = fractal_noise_generator_.curve();
+    const std::vector<glm::vec4> curve_coefficients = curve.height_coefficients();
+    if (curve_coefficients.size() > max_curve_segments)
+    {
+        // The shader's uniform arrays can't hold more segments
+        throw std::runtime_error("Hermite curve has more segments than the height map shader accepts");
+    }
+    heightmap_generator_->set_bool_uniform("apply_hermite_curve", apply_hermite_curve_);
+    heightmap_generator_->set_int_uniform("curve_segments", static_cast<int>(curve_coefficients.size()));
+    heightmap_generator_->set_float_array_uniform("curve_ranges[0]", curve.ranges().data(),
+                                                  static_cast<GLsizei>(curve.ranges().size()));
+    heightmap_generator_->set_vec4_array_uniform("curve_coefficients[0]", curve_coefficients,
+                                                 static_cast<GLsizei>(curve_coefficients.size()));
     glDispatchCompute(height_map_dim_.first / 32, height_map_dim_.second / 32, 1);
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
@@ -647,5 +765,55 @@ void Application::compute_terrain_maps()
     terrain_heightmap_->bind_image(0);
     terrain_normalmap_->bind_image(1);
     glDispatchCompute(height_map_dim_.first / 32, height_map_dim_.second / 32, 1);
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    if (!terrain_readback_)
+    {
+        return;
+    }
+
+    // Copy the maps back without waiting for the dispatches; a newer terrain replaces a pending copy
+    glDeleteSync(terrain_readback_->fence);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, terrain_readback_->buffer);
+    terrain_heightmap_->read_image<float>(0, terrain_readback_->height_map_size);
+    terrain_normalmap_->read_image<std::uint8_t>(terrain_readback_->height_map_size,
+                                                 terrain_readback_->normal_map_size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    terrain_readback_->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    terrain_readback_->key = key;
+}
+
+void Application::collect_terrain_readback()
+{
+    if (!terrain_readback_ || terrain_readback_->fence == nullptr)
+    {
+        return;
+    }
+
+    // Poll without blocking; the copy is collected on a later frame if it isn't complete yet
+    const GLenum status{glClientWaitSync(terrain_readback_->fence, 0, 0)};
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        return;
+    }
+    glDeleteSync(terrain_readback_->fence);
+    terrain_readback_->fence = nullptr;
+    if (status == GL_WAIT_FAILED)
+    {
+        return;
+    }
+
+    const std::size_t height_map_size{terrain_readback_->height_map_size};
+    const std::size_t normal_map_size{terrain_readback_->normal_map_size};
+    const auto* data = static_cast<const std::uint8_t*>(glMapNamedBufferRange(
+        terrain_readback_->buffer, 0, static_cast<GLsizeiptr>(height_map_size + normal_map_size), GL_MAP_READ_BIT));
+    if (data == nullptr)
+    {
+        return;
+    }
+    TerrainMaps maps{Image<float>{height_map_dim_.first, height_map_dim_.second},
+                     Image<std::uint8_t>{height_map_dim_.first, height_map_dim_.second, normal_map_channels}};
+    std::memcpy(maps.height_map.data(), data, height_map_size);
+    std::memcpy(maps.normal_map.data(), data + height_map_size, normal_map_size);
+    glUnmapNamedBuffer(terrain_readback_->buffer);
+    terrain_cache_->insert(terrain_readback_->key, std::move(maps));
 }
\ No newline at end of file
@@ -20,6 +20,7 @@ class ShaderProgram;
 class Skybox;
 class Texture;
 class Water;
+struct TerrainReadback;
 
 class Application
 {
@@ -67,6 +68,8 @@ private:
     FractalNoiseGenerator fractal_noise_generator_{height_map_dim_.first, height_map_dim_.second};
     std::unique_ptr<Texture> terrain_heightmap_{};
     std::unique_ptr<Texture> terrain_normalmap_{};
+    std::shared_ptr<TerrainCache> terrain_cache_{};
+    std::unique_ptr<TerrainReadback> terrain_readback_{};
     std::unique_ptr<Mesh> terrain_mesh_{};
     std::unique_ptr<Texture> terrain_albedos_;
     std::unique_ptr<Texture> terrain_normal_maps_{};
@@ -74,6 +77,7 @@ private:
     std::unique_ptr<ShaderProgram> terrain_program_{};
     float terrain_elevation_{45.0f};
     bool apply_normal_map_{true};
+    bool apply_hermite_curve_{false};
 
     // Heights, blend end and texture scale for River-Rock, Mountain-Rock and Snow, respectively
     std::array<float, 3 + 1> textures_start_height_{0.0f, 0.17f, 0.5f, 1.1f};
@@ -137,6 +141,12 @@ private:
     */
     void compute_terrain_maps();
 
+    /*
+    Store the maps of the last computed terrain in the terrain cache
+    once their copy from the GPU is complete. Called every frame.
+    */
+    void collect_terrain_readback();
+
     /*
     Manually cleanup OpenGL-related objects. Since Application
     destructor terminates the OpenGL context, it's necessary
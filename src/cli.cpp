@@ -0,0 +1,441 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gridmesh.hpp"
+#include "hermite.hpp"
+#include "image.hpp"
+#include "mapfile.hpp"
+#include "noisegeneration.hpp"
+#include "parallel.hpp"
+
+/*
+Headless terrain generator. Writes the height maps, normal maps and meshes
+of a range of tiles of the infinite terrain (see
+FractalNoiseGenerator::generate_tile) to disk. It only depends on the CPU
+generation code, so it runs on machines without a display or a GPU.
+*/
+namespace
+{
+
+constexpr std::string_view usage{
+    R"(Usage: terrain-cli [options]
+
+Generates the tiles [x0, x1] x [y0, y1] of the terrain. Tiles are square,
+share their border samples and match along their seams.
+
+Options:
+  --output DIRECTORY      Output directory (default: terrain)
+  --size N                Samples per tile side, at least 2 (default: 513)
+  --tiles X0 Y0 X1 Y1     Inclusive range of tiles (default: 0 0 0 0)
+  --lod N                 Level of detail; samples are 2^N texels apart (default: 0)
+  --seed N                Seed of the random octave offsets (default: 0)
+  --octaves N             Number of octaves (default: 8)
+  --scale X               Noise scale (default: 3)
+  --lacunarity X          Lacunarity (default: 2)
+  --persistance X         Persistance (default: 0.5)
+  --offset X Y            Offset added to every octave (default: 0 0)
+  --hermite               Redistribute heights with the Hermite curve
+  --normals rgba|octahedral
+                          Normal map encoding (default: rgba)
+  --height-maps           Write height maps as 8-bit PNG (height_X_Y.png)
+  --raw-height-maps       Write height maps as raw 32-bit floats (height_X_Y.f32)
+  --normal-maps           Write normal maps as PNG (normal_X_Y.png)
+  --meshes                Write meshes as Wavefront OBJ (mesh_X_Y.obj)
+  --mapped                Generate height maps straight into their raw files through
+                          a memory mapping, for tiles larger than the memory
+                          (implies --raw-height-maps)
+  --map-files             Write the height and normal maps of each tile to a chunked
+                          map file (maps_X_Y.tmap)
+  --compress              Compress the chunks of map files
+  --workers N             Number of threads, 0 for all cores (default: 0)
+  --help                  Show this message
+
+Height maps and normal maps are written when no output is selected.
+)"};
+
+struct Options
+{
+    std::filesystem::path output{"terrain"};
+    std::uint32_t size{513};
+    std::int64_t first_tile_x{0};
+    std::int64_t first_tile_y{0};
+    std::int64_t last_tile_x{0};
+    std::int64_t last_tile_y{0};
+    std::uint32_t lod{0};
+    std::uint64_t seed{0};
+    FractalNoiseGenerator::NoiseSettings noise_settings{};
+    bool hermite{false};
+    NormalEncoding normal_encoding{NormalEncoding::rgba};
+    bool height_maps{false};
+    bool raw_height_maps{false};
+    bool normal_maps{false};
+    bool meshes{false};
+    bool mapped{false};
+    bool map_files{false};
+    bool compress{false};
+    std::size_t workers{0};
+    bool help{false};
+};
+
+template<typename T>
+T parse_integer(std::string_view option, std::string_view text)
+{
+    T value{};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size())
+    {
+        throw std::invalid_argument("Invalid integer '" + std::string{text} + "' for " + std::string{option});
+    }
+    return value;
+}
+
+float parse_float(std::string_view option, std::string_view text)
+{
+    // std::from_chars for floating-point types isn't available on every supported standard library
+    const std::string value{text};
+    std::size_t end{0};
+    try
+    {
+        const float result = std::stof(value, &end);
+        if (end == value.size())
+        {
+            return result;
+        }
+    }
+    catch (const std::exception&)
+    {
+    }
+    throw std::invalid_argument("Invalid number '" + value + "' for " + std::string{option});
+}
+
+Options parse_options(int argc, char** argv)
+{
+    Options options;
+    const std::vector<std::string_view> arguments(argv + 1, argv + argc);
+    for (std::size_t i = 0; i < arguments.size(); ++i)
+    {
+        const std::string_view option{arguments[i]};
+        const auto next = [&]() {
+            if (++i >= arguments.size())
+            {
+                throw std::invalid_argument("Missing value for " + std::string{option});
+            }
+            return arguments[i];
+        };
+
+        if (option == "--output")
+        {
+            options.output = std::filesystem::path{next()};
+        }
+        else if (option == "--size")
+        {
+            options.size = parse_integer<std::uint32_t>(option, next());
+        }
+        else if (option == "--tiles")
+        {
+            options.first_tile_x = parse_integer<std::int64_t>(option, next());
+            options.first_tile_y = parse_integer<std::int64_t>(option, next());
+            options.last_tile_x = parse_integer<std::int64_t>(option, next());
+            options.last_tile_y = parse_integer<std::int64_t>(option, next());
+        }
+        else if (option == "--lod")
+        {
+            options.lod = parse_integer<std::uint32_t>(option, next());
+        }
+        else if (option == "--seed")
+        {
+            options.seed = parse_integer<std::uint64_t>(option, next());
+        }
+        else if (option == "--octaves")
+        {
+            options.noise_settings.octaves = parse_integer<int>(option, next());
+        }
+        else if (option == "--scale")
+        {
+            options.noise_settings.noise_scale = parse_float(option, next());
+        }
+        else if (option == "--lacunarity")
+        {
+            options.noise_settings.lacunarity = parse_float(option, next());
+        }
+        else if (option == "--persistance")
+        {
+            options.noise_settings.persistance = parse_float(option, next());
+        }
+        else if (option == "--offset")
+        {
+            options.noise_settings.offset.x = parse_float(option, next());
+            options.noise_settings.offset.y = parse_float(option, next());
+        }
+        else if (option == "--hermite")
+        {
+            options.hermite = true;
+        }
+        else if (option == "--normals")
+        {
+            const std::string_view encoding{next()};
+            if (encoding == "rgba")
+            {
+                options.normal_encoding = NormalEncoding::rgba;
+            }
+            else if (encoding == "octahedral")
+            {
+                options.normal_encoding = NormalEncoding::octahedral;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown normal encoding '" + std::string{encoding} + "'");
+            }
+        }
+        else if (option == "--height-maps")
+        {
+            options.height_maps = true;
+        }
+        else if (option == "--raw-height-maps")
+        {
+            options.raw_height_maps = true;
+        }
+        else if (option == "--normal-maps")
+        {
+            options.normal_maps = true;
+        }
+        else if (option == "--meshes")
+        {
+            options.meshes = true;
+        }
+        else if (option == "--mapped")
+        {
+            options.mapped = true;
+            options.raw_height_maps = true;
+        }
+        else if (option == "--map-files")
+        {
+            options.map_files = true;
+        }
+        else if (option == "--compress")
+        {
+            options.compress = true;
+        }
+        else if (option == "--workers")
+        {
+            options.workers = parse_integer<std::size_t>(option, next());
+        }
+        else if (option == "--help" || option == "-h")
+        {
+            options.help = true;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option '" + std::string{option} + "'");
+        }
+    }
+
+    if (options.size < 2)
+    {
+        throw std::invalid_argument("Tiles need at least 2 samples per side");
+    }
+    if (options.lod > 30)
+    {
+        throw std::invalid_argument("Level of detail must be at most 30");
+    }
+    if (options.noise_settings.octaves < 1)
+    {
+        throw std::invalid_argument("At least one octave is required");
+    }
+    if (options.last_tile_x < options.first_tile_x || options.last_tile_y < options.first_tile_y)
+    {
+        throw std::invalid_argument("Empty tile range");
+    }
+    if (!options.height_maps && !options.raw_height_maps && !options.normal_maps && !options.meshes &&
+        !options.map_files)
+    {
+        options.height_maps = true;
+        options.normal_maps = true;
+    }
+    return options;
+}
+
+std::string tile_file_name(std::string_view prefix, std::int64_t tile_x, std::int64_t tile_y,
+                           std::string_view extension)
+{
+    return std::string{prefix} + "_" + std::to_string(tile_x) + "_" + std::to_string(tile_y) + std::string{extension};
+}
+
+// Curve mapping every height in [0, 1] to itself, exactly
+CubicHermiteCurve identity_curve()
+{
+    return CubicHermiteCurve{std::vector<glm::vec2>{{0.0f, 0.0f}, {1.0f, 1.0f}},
+                             std::vector<glm::vec2>{{1.0f, 1.0f}, {1.0f, 1.0f}}, std::vector<float>{0.0f, 1.0f}};
+}
+
+void save_raw_heights(const std::filesystem::path& path, const Image<float>& height_map)
+{
+    // Rows are written without their padding
+    std::ofstream file{path, std::ios::binary};
+    for (std::size_t i = 0; i < height_map.height(); ++i)
+    {
+        file.write(reinterpret_cast<const char*>(height_map.row(i)),
+                   static_cast<std::streamsize>(height_map.width() * sizeof(float)));
+    }
+    if (!file)
+    {
+        throw std::runtime_error("Failure to write " + path.string());
+    }
+}
+
+/*
+Write a grid_mesh as Wavefront OBJ. The mesh is moved from the origin to
+the tile's place in the world and scaled by the spacing of its samples,
+so the meshes of neighbouring tiles line up.
+*/
+void save_mesh(const std::filesystem::path& path, const std::vector<float>& vertices,
+               const std::vector<std::uint32_t>& indices, float origin_x, float origin_z, float step)
+{
+    constexpr std::size_t attributes{5};
+    std::ofstream file{path};
+    for (std::size_t vertex = 0; vertex < vertices.size(); vertex += attributes)
+    {
+        file << "v " << origin_x + vertices[vertex] * step << ' ' << vertices[vertex + 1] << ' '
+             << origin_z + vertices[vertex + 2] * step << '\n';
+    }
+    for (std::size_t vertex = 0; vertex < vertices.size(); vertex += attributes)
+    {
+        file << "vt " << vertices[vertex + 3] << ' ' << vertices[vertex + 4] << '\n';
+    }
+    for (std::size_t index = 0; index + 2 < indices.size(); index += 3)
+    {
+        // OBJ indices start at 1; positions and texture coordinates share them
+        const std::uint32_t a{indices[index] + 1};
+        const std::uint32_t b{indices[index + 1] + 1};
+        const std::uint32_t c{indices[index + 2] + 1};
+        file << "f " << a << '/' << a << ' ' << b << '/' << b << ' ' << c << '/' << c << '\n';
+    }
+    if (!file)
+    {
+        throw std::runtime_error("Failure to write " + path.string());
+    }
+}
+
+void write_tile(const FractalNoiseGenerator& generator, const Options& options, std::int64_t tile_x,
+                std::int64_t tile_y, std::size_t workers)
+{
+    const std::filesystem::path raw_path{options.output / tile_file_name("height", tile_x, tile_y, ".f32")};
+    Image<float> height_map = options.mapped ? Image<float>{raw_path, options.size, options.size}
+                                             : Image<float>{options.size, options.size};
+    height_map.advise(AccessPattern::sequential);
+    generator.generate_tile(height_map, tile_x, tile_y, options.lod, options.hermite);
+
+    if (options.meshes)
+    {
+        // The heights are final, so the mesh and the maps of a tile agree with or without --hermite
+        const int size{static_cast<int>(options.size)};
+        const auto [vertices, indices] = grid_mesh(size, size, height_map, identity_curve(), workers);
+        const float step{static_cast<float>(std::int64_t{1} << options.lod)};
+        const float half_size{static_cast<float>(options.size) / 2.0f};
+        const float tile_span{static_cast<float>(options.size - 1)};
+        save_mesh(options.output / tile_file_name("mesh", tile_x, tile_y, ".obj"), vertices, indices,
+                  (static_cast<float>(tile_x) * tile_span + half_size) * step,
+                  (static_cast<float>(tile_y) * tile_span + half_size) * step, step);
+    }
+
+    if (options.height_maps)
+    {
+        save_image((options.output / tile_file_name("height", tile_x, tile_y, ".png")).string(),
+                   from_float_to_uint8(height_map));
+    }
+    if (options.raw_height_maps && !options.mapped)
+    {
+        save_raw_heights(raw_path, height_map);
+    }
+    if (!options.normal_maps && !options.map_files)
+    {
+        return;
+    }
+    const Image<std::uint8_t> normal_map = compute_normal_map(height_map, options.normal_encoding, workers);
+    if (options.normal_maps)
+    {
+        save_image((options.output / tile_file_name("normal", tile_x, tile_y, ".png")).string(), normal_map);
+    }
+    if (options.map_files)
+    {
+        const ChunkCompression compression{options.compress ? ChunkCompression::delta_rle : ChunkCompression::none};
+        MapFileWriter map_file{options.output / tile_file_name("maps", tile_x, tile_y, ".tmap")};
+        map_file.add_map("height", height_map.view(), 256, compression);
+        map_file.add_map("normal", normal_map.view(), 256, compression);
+        map_file.finish();
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parse_options(argc, argv);
+        if (options.help)
+        {
+            std::cout << usage;
+            return 0;
+        }
+
+        std::filesystem::create_directories(options.output);
+
+        const std::int64_t columns{options.last_tile_x - options.first_tile_x + 1};
+        const std::int64_t rows{options.last_tile_y - options.first_tile_y + 1};
+        const auto tiles = static_cast<std::size_t>(columns * rows);
+
+        // Tiles are spread across the workers; the workers left over split each tile in row bands
+        const std::size_t workers{options.workers == 0 ? hardware_workers() : options.workers};
+        const std::size_t tile_workers{std::min(tiles, workers)};
+        const std::size_t workers_per_tile{std::max<std::size_t>(1, workers / tile_workers)};
+
+        // Tiles don't use the generator's own maps, so they are kept at the minimum size
+        FractalNoiseGenerator generator{2, 2};
+        generator.noise_settings = options.noise_settings;
+        generator.set_workers(workers_per_tile);
+        generator.generate_random_offsets(options.seed);
+
+        std::vector<std::exception_ptr> errors(tile_workers);
+        parallel_for_bands(tiles, tile_workers, [&](std::size_t band, std::size_t first_tile, std::size_t last_tile) {
+            try
+            {
+                for (std::size_t tile = first_tile; tile < last_tile; ++tile)
+                {
+                    const auto column = static_cast<std::int64_t>(tile) % columns;
+                    const auto row = static_cast<std::int64_t>(tile) / columns;
+                    write_tile(generator, options, options.first_tile_x + column, options.first_tile_y + row,
+                               workers_per_tile);
+                }
+            }
+            catch (...)
+            {
+                errors[band] = std::current_exception();
+            }
+        });
+        for (const std::exception_ptr& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
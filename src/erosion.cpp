@@ -0,0 +1,354 @@
+#include "erosion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "random.hpp"
+#include "simd.hpp"
+
+namespace
+{
+
+struct BrushTexel
+{
+    int offset_x;
+    int offset_y;
+    float weight;
+};
+
+// Texels within radius of a cell, weighted by their distance to it and normalized to a sum of 1
+std::vector<BrushTexel> make_brush(int radius)
+{
+    std::vector<BrushTexel> brush;
+    float weights_sum{0.0f};
+    for (int offset_y = -radius; offset_y <= radius; ++offset_y)
+    {
+        for (int offset_x = -radius; offset_x <= radius; ++offset_x)
+        {
+            const float distance = std::sqrt(static_cast<float>(offset_x * offset_x + offset_y * offset_y));
+            const float weight = std::max(0.0f, static_cast<float>(radius) - distance);
+            if (weight > 0.0f || radius == 0)
+            {
+                brush.push_back({offset_x, offset_y, radius == 0 ? 1.0f : weight});
+                weights_sum += brush.back().weight;
+            }
+        }
+    }
+    for (BrushTexel& texel : brush)
+    {
+        texel.weight /= weights_sum;
+    }
+    return brush;
+}
+
+struct HeightGradient
+{
+    float height;
+    float gradient_x;
+    float gradient_y;
+};
+
+// Bilinear height and gradient at a point inside the map, whose rows are pitch values apart
+HeightGradient height_and_gradient(const float* heights, std::size_t pitch, float x, float y)
+{
+    const auto cell_x = static_cast<std::size_t>(x);
+    const auto cell_y = static_cast<std::size_t>(y);
+    const float u{x - static_cast<float>(cell_x)};
+    const float v{y - static_cast<float>(cell_y)};
+
+    const float* top = heights + cell_y * pitch + cell_x;
+    const float* bottom = top + pitch;
+    const float top_left{top[0]};
+    const float top_right{top[1]};
+    const float bottom_left{bottom[0]};
+    const float bottom_right{bottom[1]};
+
+    return HeightGradient{
+        .height = top_left * (1 - u) * (1 - v) + top_right * u * (1 - v) + bottom_left * (1 - u) * v +
+                  bottom_right * u * v,
+        .gradient_x = (top_right - top_left) * (1 - v) + (bottom_right - bottom_left) * v,
+        .gradient_y = (bottom_left - top_left) * (1 - u) + (bottom_right - top_right) * u,
+    };
+}
+
+void simulate_droplet(float* heights, std::size_t width, std::size_t height, std::size_t pitch,
+                      const HydraulicErosionSettings& settings, const std::vector<BrushTexel>& brush, float x, float y)
+{
+    float direction_x{0.0f};
+    float direction_y{0.0f};
+    float speed{1.0f};
+    float water{1.0f};
+    float sediment{0.0f};
+
+    for (std::uint32_t lifetime = 0; lifetime < settings.max_lifetime; ++lifetime)
+    {
+        const auto cell_x = static_cast<std::size_t>(x);
+        const auto cell_y = static_cast<std::size_t>(y);
+        const float u{x - static_cast<float>(cell_x)};
+        const float v{y - static_cast<float>(cell_y)};
+        const HeightGradient current = height_and_gradient(heights, pitch, x, y);
+
+        // Blend the previous direction with the downhill direction and move by one texel
+        direction_x = direction_x * settings.inertia - current.gradient_x * (1 - settings.inertia);
+        direction_y = direction_y * settings.inertia - current.gradient_y * (1 - settings.inertia);
+        const float length = std::sqrt(direction_x * direction_x + direction_y * direction_y);
+        if (length == 0.0f)
+        {
+            break;
+        }
+        direction_x /= length;
+        direction_y /= length;
+        x += direction_x;
+        y += direction_y;
+        if (x < 0.0f || y < 0.0f || x >= static_cast<float>(width - 1) || y >= static_cast<float>(height - 1))
+        {
+            break;
+        }
+
+        const float delta_height = height_and_gradient(heights, pitch, x, y).height - current.height;
+        const float capacity = std::max(-delta_height * speed * water * settings.sediment_capacity,
+                                        settings.min_sediment_capacity);
+
+        if (sediment > capacity || delta_height > 0.0f)
+        {
+            // Going uphill fills the pit behind the droplet, otherwise drop the excess sediment
+            const float deposit =
+                delta_height > 0.0f ? std::min(delta_height, sediment) : (sediment - capacity) * settings.deposit_speed;
+            sediment -= deposit;
+
+            float* top = heights + cell_y * pitch + cell_x;
+            float* bottom = top + pitch;
+            top[0] += deposit * (1 - u) * (1 - v);
+            top[1] += deposit * u * (1 - v);
+            bottom[0] += deposit * (1 - u) * v;
+            bottom[1] += deposit * u * v;
+        }
+        else
+        {
+            // Erode around the previous cell, never more than the height difference to avoid digging holes
+            const float erosion = std::min((capacity - sediment) * settings.erode_speed, -delta_height);
+            for (const BrushTexel& texel : brush)
+            {
+                const std::ptrdiff_t i = static_cast<std::ptrdiff_t>(cell_y) + texel.offset_y;
+                const std::ptrdiff_t j = static_cast<std::ptrdiff_t>(cell_x) + texel.offset_x;
+                if (i < 0 || j < 0 || i >= static_cast<std::ptrdiff_t>(height) ||
+                    j >= static_cast<std::ptrdiff_t>(width))
+                {
+                    continue;
+                }
+                float& texel_height = heights[i * static_cast<std::ptrdiff_t>(pitch) + j];
+                const float eroded = std::min(texel_height, erosion * texel.weight);
+                texel_height -= eroded;
+                sediment += eroded;
+            }
+        }
+
+        speed = std::sqrt(std::max(0.0f, speed * speed - delta_height * settings.gravity));
+        water *= 1 - settings.evaporate_speed;
+    }
+}
+
+/*
+New height of a texel from its height and those of its 4 neighbours. Each
+neighbour gives or takes rate times the height difference in excess of talus.
+*/
+template<typename Value>
+Value thermal_update(Value center, Value left, Value right, Value top, Value bottom, Value talus, Value rate)
+{
+    using simd::max;
+    const Value zero{0.0f};
+    const auto inflow = [&](Value neighbour) {
+        return max(zero, neighbour - center - talus) - max(zero, center - neighbour - talus);
+    };
+    return center + rate * (inflow(left) + inflow(right) + inflow(top) + inflow(bottom));
+}
+
+/*
+Compute a row of the next iteration and return the largest change in it.
+Texels outside the map are treated as having the height of the border,
+so nothing flows out of the map.
+*/
+float thermal_row(const float* top, const float* center, const float* bottom, float* next, std::size_t width,
+                  float talus, float rate)
+{
+    using Batch = simd::NativeFloatBatch;
+    using simd::abs;
+    using simd::max;
+
+    const auto scalar_update = [&](std::size_t j) {
+        const float left{center[j > 0 ? j - 1 : j]};
+        const float right{center[j + 1 < width ? j + 1 : j]};
+        next[j] = thermal_update(center[j], left, right, top[j], bottom[j], talus, rate);
+        return std::fabs(next[j] - center[j]);
+    };
+
+    float max_change{scalar_update(0)};
+    Batch max_changes{0.0f};
+    std::size_t j{1};
+    for (; j + Batch::lanes < width; j += Batch::lanes)
+    {
+        const Batch value = Batch::load(center + j);
+        const Batch updated =
+            thermal_update(value, Batch::load(center + j - 1), Batch::load(center + j + 1), Batch::load(top + j),
+                           Batch::load(bottom + j), Batch{talus}, Batch{rate});
+        updated.store(next + j);
+        max_changes = max(max_changes, abs(updated - value));
+    }
+    max_change = std::max(max_change, horizontal_max(max_changes));
+
+    for (; j < width; ++j)
+    {
+        max_change = std::max(max_change, scalar_update(j));
+    }
+    return max_change;
+}
+
+} // namespace
+
+void erode_hydraulic(Image<float>& height_map, const HydraulicErosionSettings& settings, std::size_t workers)
+{
+    const std::size_t width{height_map.width()};
+    const std::size_t height{height_map.height()};
+    if (width < 2 || height < 2 || settings.droplets == 0)
+    {
+        return;
+    }
+
+    // Tiles of the same parity are one tile apart, which must exceed the reach of two droplets
+    const std::size_t reach{settings.max_lifetime + settings.erosion_radius + 2};
+    const std::size_t tile_size{std::max<std::size_t>(64, 2 * reach)};
+    const std::size_t tile_columns{(width + tile_size - 1) / tile_size};
+    const std::size_t tile_rows{(height + tile_size - 1) / tile_size};
+    const std::vector<BrushTexel> brush = make_brush(static_cast<int>(settings.erosion_radius));
+
+    // Droplets are split across tiles in proportion to their area
+    const std::uint64_t map_area{static_cast<std::uint64_t>(width) * height};
+    const auto droplets_before = [&](std::size_t tile_row, std::size_t tile_column) {
+        const std::size_t first_row{std::min(tile_row * tile_size, height)};
+        const std::size_t rows{std::min(tile_size, height - first_row)};
+        const std::uint64_t area_before{static_cast<std::uint64_t>(first_row) * width +
+                                        static_cast<std::uint64_t>(std::min(tile_column * tile_size, width)) * rows};
+        return settings.droplets * area_before / map_area;
+    };
+
+    float* heights = height_map.data();
+    const std::size_t pitch{height_map.pitch()};
+    for (std::size_t parity = 0; parity < 4; ++parity)
+    {
+        std::vector<std::array<std::size_t, 2>> tiles;
+        for (std::size_t tile_row = parity / 2; tile_row < tile_rows; tile_row += 2)
+        {
+            for (std::size_t tile_column = parity % 2; tile_column < tile_columns; tile_column += 2)
+            {
+                tiles.push_back({tile_row, tile_column});
+            }
+        }
+
+        parallel_for_bands(tiles.size(), workers, [&](std::size_t, std::size_t first_tile, std::size_t last_tile) {
+            for (std::size_t t = first_tile; t < last_tile; ++t)
+            {
+                const auto [tile_row, tile_column] = tiles[t];
+                const std::uint64_t first_droplet = droplets_before(tile_row, tile_column);
+                const std::uint64_t last_droplet = tile_column + 1 < tile_columns
+                                                       ? droplets_before(tile_row, tile_column + 1)
+                                                       : droplets_before(tile_row + 1, 0);
+
+                const float origin_x{static_cast<float>(tile_column * tile_size)};
+                const float origin_y{static_cast<float>(tile_row * tile_size)};
+                const float extent_x{static_cast<float>(std::min(tile_size, width - 1 - tile_column * tile_size))};
+                const float extent_y{static_cast<float>(std::min(tile_size, height - 1 - tile_row * tile_size))};
+                if (extent_x <= 0.0f || extent_y <= 0.0f)
+                {
+                    continue;
+                }
+
+                const std::uint64_t stream = random_stream(static_cast<std::int64_t>(tile_column),
+                                                           static_cast<std::int64_t>(tile_row));
+                for (std::uint64_t droplet = 0; droplet < last_droplet - first_droplet; ++droplet)
+                {
+                    const float x = origin_x + extent_x * random_float(settings.seed, stream, 2 * droplet);
+                    const float y = origin_y + extent_y * random_float(settings.seed, stream, 2 * droplet + 1);
+                    simulate_droplet(heights, width, height, pitch, settings, brush, x, y);
+                }
+            }
+        });
+    }
+}
+
+std::uint32_t erode_thermal(Image<float>& height_map, const ThermalErosionSettings& settings, std::size_t workers)
+{
+    const std::size_t width{height_map.width()};
+    const std::size_t height{height_map.height()};
+    if (width == 0 || height == 0)
+    {
+        return 0;
+    }
+
+    // With 4 neighbours exchanging at once, a rate of 1/8 brings a pair exactly to the talus
+    const float rate{settings.strength / 8.0f};
+    // The scratch buffer has the layout of the map, so rows are the same pitch apart in both, and its backing: a
+    // file-backed map gets a scratch file next to its own, removed once the erosion is done
+    const RowPadding padding{height_map.is_contiguous() ? RowPadding::none : RowPadding::aligned};
+    std::optional<std::filesystem::path> scratch_file = height_map.file();
+    if (scratch_file)
+    {
+        scratch_file->concat(".thermal");
+    }
+    Image<float> next = scratch_file ? Image<float>{*scratch_file, width, height, 1, padding}
+                                     : Image<float>{width, height, 1, padding};
+    assert(next.pitch() == height_map.pitch());
+    const std::size_t pitch{height_map.pitch()};
+    std::vector<float> band_changes(band_count(height, workers));
+
+    // The passes alternate between the two buffers; the caller's storage is kept, e.g. for a file-backed map
+    float* current = height_map.data();
+    float* updated = next.data();
+    std::uint32_t iteration{0};
+    while (iteration < settings.iterations)
+    {
+        parallel_for_bands(height, workers, [&](std::size_t band, std::size_t first_row, std::size_t last_row) {
+            float max_change{0.0f};
+            for (std::size_t i = first_row; i < last_row; ++i)
+            {
+                const float* center = current + i * pitch;
+                const float* top = i > 0 ? center - pitch : center;
+                const float* bottom = i + 1 < height ? center + pitch : center;
+                max_change =
+                    std::max(max_change, thermal_row(top, center, bottom, updated + i * pitch, width,
+                                                     settings.talus, rate));
+            }
+            band_changes[band] = max_change;
+        });
+
+        std::swap(current, updated);
+        ++iteration;
+        if (*std::max_element(band_changes.begin(), band_changes.end()) <= settings.tolerance)
+        {
+            break;
+        }
+    }
+
+    // After an odd number of iterations the result is in the scratch buffer
+    if (current != height_map.data())
+    {
+        for (std::size_t i = 0; i < height; ++i)
+        {
+            std::copy_n(current + i * pitch, width, height_map.row(i));
+        }
+    }
+
+    if (scratch_file)
+    {
+        // Unmap the scratch file before removing it
+        next = Image<float>{0, 0};
+        std::filesystem::remove(*scratch_file);
+    }
+    return iteration;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef EROSION_HPP
+#define EROSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image.hpp"
+
+/*
+Parameters of the droplet-based hydraulic erosion. Heights are expected
+in [0, 1] with a horizontal spacing of one texel.
+*/
+struct HydraulicErosionSettings
+{
+    std::uint32_t droplets{200000};
+    // Maximum number of steps of a droplet; each step moves it by one texel
+    std::uint32_t max_lifetime{30};
+    // Radius, in texels, of the area eroded around a droplet
+    std::uint32_t erosion_radius{3};
+    // How much a droplet keeps its direction instead of following the slope
+    float inertia{0.05f};
+    float sediment_capacity{4.0f};
+    float min_sediment_capacity{0.01f};
+    float deposit_speed{0.3f};
+    float erode_speed{0.3f};
+    float evaporate_speed{0.01f};
+    float gravity{4.0f};
+    std::uint64_t seed{0};
+};
+
+/*
+Simulate water droplets flowing downhill over the height map, eroding
+sediment on steep slopes and depositing it where they slow down.
+
+Droplets are assigned to square tiles by their starting position and
+can't travel further than max_lifetime + erosion_radius texels from it.
+Tiles are at least twice that size and are processed in four passes,
+one per tile parity, so tiles of the same pass never touch the same
+texels and run in parallel without locks. Droplet positions are drawn
+from the counter-based RNG, keyed by the seed and the tile, so the
+result only depends on the settings and not on the number of workers
+(0 means one worker per hardware thread).
+*/
+void erode_hydraulic(Image<float>& height_map, const HydraulicErosionSettings& settings, std::size_t workers = 0);
+
+/*
+Parameters of the thermal erosion. Material slides to a lower neighbour
+wherever the height difference exceeds talus, the height difference
+between adjacent texels at the angle of repose.
+*/
+struct ThermalErosionSettings
+{
+    std::uint32_t iterations{100};
+    float talus{0.002f};
+    // Fraction in (0, 1] of the excess moved per iteration
+    float strength{0.5f};
+    // Stop early once no texel changes by more than this in an iteration
+    float tolerance{1e-6f};
+};
+
+/*
+Relax slopes steeper than the talus angle with a cellular automaton. Each
+iteration exchanges material between every texel and its 4 neighbours
+in proportion to the height difference in excess of talus. The update of
+a texel only reads the previous iteration, so the map is double-buffered
+(for a file-backed map, through a temporary file next to its own),
+vectorized along rows and split in row bands across workers (0 means
+one worker per hardware thread); the result doesn't depend on the number
+of workers. The exchange is symmetric, so the total volume is preserved.
+Returns the number of iterations performed.
+*/
+std::uint32_t erode_thermal(Image<float>& height_map, const ThermalErosionSettings& settings, std::size_t workers = 0);
+
+#endif // EROSION_HPP
\ No newline at end of file
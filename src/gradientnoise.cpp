@@ -0,0 +1,159 @@
+#include "gradientnoise.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include "random.hpp"
+
+float gradient_noise(glm::vec2 point)
+{
+    return gradient_noise(point.x, point.y);
+}
+
+void gradient_noise(std::span<const float> x, std::span<const float> y, std::span<float> noise)
+{
+    assert(x.size() == y.size());
+    assert(x.size() == noise.size());
+
+    using Batch = simd::NativeFloatBatch;
+    std::size_t index{0};
+    for (; index + Batch::lanes <= noise.size(); index += Batch::lanes)
+    {
+        gradient_noise(Batch::load(&x[index]), Batch::load(&y[index])).store(&noise[index]);
+    }
+
+    for (; index < noise.size(); ++index)
+    {
+        noise[index] = gradient_noise(x[index], y[index]);
+    }
+}
+
+float fractal_noise(glm::vec2 point, std::span<const glm::vec2> offsets, float noise_scale, float lacunarity,
+                    float persistance)
+{
+    float frequency{1.0f};
+    float amplitude{1.0f};
+    float noise_height{0.0f};
+    for (const glm::vec2 offset : offsets)
+    {
+        const float scale{frequency / noise_scale};
+        noise_height +=
+            amplitude * gradient_noise(scale * point.x + frequency * offset.x, scale * point.y + frequency * offset.y);
+        frequency *= lacunarity;
+        amplitude *= persistance;
+    }
+    return noise_height;
+}
+
+float fractal_noise_bound(float persistance, int octaves)
+{
+    float amplitude{1.0f};
+    float amplitudes_sum{0.0f};
+    for (int octave = 0; octave < octaves; ++octave)
+    {
+        amplitudes_sum += std::abs(amplitude);
+        amplitude *= persistance;
+    }
+    return gradient_noise_bound * amplitudes_sum;
+}
+
+glm::vec2 octave_offset(std::uint64_t seed, std::uint32_t octave, std::uint64_t stream)
+{
+    const std::uint64_t counter{2 * static_cast<std::uint64_t>(octave)};
+    return {random_float(seed, stream, counter, -10000.0f, 10000.0f),
+            random_float(seed, stream, counter + 1, -10000.0f, 10000.0f)};
+}
+
+std::vector<FractalNoiseOctave> fractal_noise_octaves(std::span<const glm::vec2> offsets, float noise_scale,
+                                                      float lacunarity, float persistance)
+{
+    std::vector<FractalNoiseOctave> octaves;
+    octaves.reserve(offsets.size());
+    float frequency{1.0f};
+    float amplitude{1.0f};
+    for (const glm::vec2 offset : offsets)
+    {
+        octaves.push_back({frequency / noise_scale, frequency * offset.x, frequency * offset.y, amplitude});
+        frequency *= lacunarity;
+        amplitude *= persistance;
+    }
+    return octaves;
+}
+
+void fractal_noise_row(std::span<float> row, glm::vec2 start, float step, std::span<const glm::vec2> offsets,
+                       float noise_scale, float lacunarity, float persistance)
+{
+    const std::vector<FractalNoiseOctave> octaves =
+        fractal_noise_octaves(offsets, noise_scale, lacunarity, persistance);
+    fractal_noise_row(row, start, step, octaves);
+}
+
+void fractal_noise_row(std::span<float> row, glm::vec2 start, float step, std::span<const FractalNoiseOctave> octaves)
+{
+    using Batch = simd::NativeFloatBatch;
+
+    // Offsets between consecutive lanes of a batch
+    alignas(64) float lane_steps[Batch::lanes];
+    for (std::size_t lane = 0; lane < Batch::lanes; ++lane)
+    {
+        lane_steps[lane] = static_cast<float>(lane);
+    }
+    const Batch lane_offsets = Batch::load(lane_steps);
+
+    std::size_t column{0};
+    for (; column + Batch::lanes <= row.size(); column += Batch::lanes)
+    {
+        const Batch x = Batch{start.x} + (Batch{static_cast<float>(column)} + lane_offsets) * Batch{step};
+        Batch noise_height{0.0f};
+        for (const FractalNoiseOctave& constants : octaves)
+        {
+            const Batch sample_x = Batch{constants.scale} * x + Batch{constants.offset_x};
+            const Batch sample_y{constants.scale * start.y + constants.offset_y};
+            noise_height = noise_height + Batch{constants.amplitude} * gradient_noise(sample_x, sample_y);
+        }
+        noise_height.store(&row[column]);
+    }
+
+    for (; column < row.size(); ++column)
+    {
+        const float x{start.x + static_cast<float>(column) * step};
+        float noise_height{0.0f};
+        for (const FractalNoiseOctave& constants : octaves)
+        {
+            noise_height += constants.amplitude * gradient_noise(constants.scale * x + constants.offset_x,
+                                                                 constants.scale * start.y + constants.offset_y);
+        }
+        row[column] = noise_height;
+    }
+}
+
+void octave_noise_row(std::span<float> row, glm::vec2 start, float step, glm::vec2 offset, float frequency,
+                      float amplitude, float noise_scale)
+{
+    using Batch = simd::NativeFloatBatch;
+
+    alignas(64) float lane_steps[Batch::lanes];
+    for (std::size_t lane = 0; lane < Batch::lanes; ++lane)
+    {
+        lane_steps[lane] = static_cast<float>(lane);
+    }
+    const Batch lane_offsets = Batch::load(lane_steps);
+
+    const float scale{frequency / noise_scale};
+    const Batch sample_y{scale * start.y + frequency * offset.y};
+    std::size_t column{0};
+    for (; column + Batch::lanes <= row.size(); column += Batch::lanes)
+    {
+        const Batch x = Batch{start.x} + (Batch{static_cast<float>(column)} + lane_offsets) * Batch{step};
+        const Batch sample_x = Batch{scale} * x + Batch{frequency * offset.x};
+        const Batch noise_height = Batch::load(&row[column]) + Batch{amplitude} * gradient_noise(sample_x, sample_y);
+        noise_height.store(&row[column]);
+    }
+
+    for (; column < row.size(); ++column)
+    {
+        const float x{start.x + static_cast<float>(column) * step};
+        row[column] +=
+            amplitude * gradient_noise(scale * x + frequency * offset.x, scale * start.y + frequency * offset.y);
+    }
+}
\ No newline at end of file
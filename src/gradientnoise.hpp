@@ -0,0 +1,107 @@
+#ifndef GRADIENT_NOISE_HPP
+#define GRADIENT_NOISE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "simd.hpp"
+
+/*
+2D gradient (Perlin) noise, following the same formulation as
+glm::perlin(glm::vec2): permutation polynomial hashing modulo 289,
+gradients on a diamond and quintic fade curves. The kernel is a
+template, so the same sequence of operations is evaluated on a single
+float (the scalar reference) or on 4, 8 or 16 points at once on a
+simd::FloatBatch, with identical results on every lane.
+*/
+template<typename Value>
+Value gradient_noise(Value x, Value y);
+
+// Scalar reference implementation
+float gradient_noise(glm::vec2 point);
+
+/*
+Upper bound for |gradient_noise|. The hash repeats every 289 cells, so
+a dense search over all 289 x 289 cells, refined around the largest
+samples, finds the true maximum of the kernel: 0.9715. The bound adds
+a margin of about 2% to it.
+*/
+inline constexpr float gradient_noise_bound{0.99f};
+
+/*
+Evaluate gradient noise for every (x[n], y[n]) pair using the widest
+batch available, and store the results in noise[n].
+All spans must have the same size.
+*/
+void gradient_noise(std::span<const float> x, std::span<const float> y, std::span<float> noise);
+
+/*
+Fractal Brownian Motion (fBm) of gradient noise at a single point,
+accumulating one octave per entry of offsets. Each octave multiplies
+the frequency by lacunarity and the amplitude by persistance.
+*/
+float fractal_noise(glm::vec2 point, std::span<const glm::vec2> offsets, float noise_scale, float lacunarity,
+                    float persistance);
+
+/*
+Upper bound for |fractal_noise| with the given persistance and number of octaves.
+*/
+float fractal_noise_bound(float persistance, int octaves);
+
+/*
+Random sampling offset of an fBm octave, uniform in [-10000, 10000)^2.
+It is a pure function of the seed, the octave and the stream (see
+random.hpp), so any worker can compute the offsets of any octave on its
+own. Terrain that has to be continuous across tiles uses the same stream
+for every tile.
+*/
+glm::vec2 octave_offset(std::uint64_t seed, std::uint32_t octave, std::uint64_t stream = 0);
+
+/*
+Per-octave constants of an fBm sum. Octave k samples gradient noise at
+(scale * x + offset_x, scale * y + offset_y) and weights it by amplitude.
+*/
+struct FractalNoiseOctave
+{
+    float scale;
+    float offset_x;
+    float offset_y;
+    float amplitude;
+};
+
+/*
+Precompute the constants of each octave once, so the sample loops don't
+recompute frequencies and amplitudes for every texel. The values match
+those computed by fractal_noise exactly.
+*/
+std::vector<FractalNoiseOctave> fractal_noise_octaves(std::span<const glm::vec2> offsets, float noise_scale,
+                                                      float lacunarity, float persistance);
+
+/*
+Fill a whole row with fBm noise. Sample n of the row is located at
+(start.x + n * step, start.y) and gives the same value as fractal_noise
+on that point, but consecutive samples are evaluated in SIMD batches.
+*/
+void fractal_noise_row(std::span<float> row, glm::vec2 start, float step, std::span<const glm::vec2> offsets,
+                       float noise_scale, float lacunarity, float persistance);
+
+// Same as above with octaves precomputed by fractal_noise_octaves
+void fractal_noise_row(std::span<float> row, glm::vec2 start, float step, std::span<const FractalNoiseOctave> octaves);
+
+/*
+Add a single fBm octave to a row: row[n] += amplitude * noise at sample n,
+with samples laid out as in fractal_noise_row. Adding the octaves of
+fractal_noise_row one at a time, in order, to a zeroed row gives exactly
+the same values; a negative amplitude removes a previously added octave
+(up to rounding).
+*/
+void octave_noise_row(std::span<float> row, glm::vec2 start, float step, glm::vec2 offset, float frequency,
+                      float amplitude, float noise_scale);
+
+#include "gradientnoise.inl"
+
+#endif // GRADIENT_NOISE_HPP
\ No newline at end of file
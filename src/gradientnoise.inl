@@ -0,0 +1,81 @@
+#include "gradientnoise.hpp"
+
+namespace detail
+{
+
+template<typename Value>
+Value mod289(Value x)
+{
+    using simd::floor;
+    return x - floor(x * Value{1.0f / 289.0f}) * Value{289.0f};
+}
+
+template<typename Value>
+Value permute(Value x)
+{
+    return mod289(((x * Value{34.0f}) + Value{1.0f}) * x);
+}
+
+template<typename Value>
+Value taylor_inverse_sqrt(Value r)
+{
+    return Value{1.79284291400159f} - Value{0.85373472095314f} * r;
+}
+
+template<typename Value>
+Value fade(Value t)
+{
+    return (t * t) * t * (t * (t * Value{6.0f} - Value{15.0f}) + Value{10.0f});
+}
+
+template<typename Value>
+Value mix(Value x, Value y, Value a)
+{
+    return x * (Value{1.0f} - a) + y * a;
+}
+
+} // namespace detail
+
+template<typename Value>
+Value gradient_noise(Value x, Value y)
+{
+    // Resolves to the scalar overloads for floats and to the batch operations otherwise
+    using simd::abs;
+    using simd::floor;
+
+    // Integer and fractional parts of the lattice cell corners
+    const Value floor_x = floor(x);
+    const Value floor_y = floor(y);
+    const Value fraction_x0 = x - floor_x;
+    const Value fraction_y0 = y - floor_y;
+    const Value fraction_x1 = fraction_x0 - Value{1.0f};
+    const Value fraction_y1 = fraction_y0 - Value{1.0f};
+
+    // Wrap lattice coordinates to avoid truncation effects in the permutation
+    const auto wrap = [](Value value) { return value - Value{289.0f} * floor(value / Value{289.0f}); };
+    const Value cell_x0 = wrap(floor_x);
+    const Value cell_y0 = wrap(floor_y);
+    const Value cell_x1 = wrap(floor_x + Value{1.0f});
+    const Value cell_y1 = wrap(floor_y + Value{1.0f});
+
+    // Hash each corner and compute its contribution
+    const auto corner = [](Value cell_x, Value cell_y, Value fraction_x, Value fraction_y) {
+        const Value hash = detail::permute(detail::permute(cell_x) + cell_y);
+        Value gradient_x = Value{2.0f} * (hash / Value{41.0f} - floor(hash / Value{41.0f})) - Value{1.0f};
+        const Value gradient_y = abs(gradient_x) - Value{0.5f};
+        gradient_x = gradient_x - floor(gradient_x + Value{0.5f});
+        const Value norm = detail::taylor_inverse_sqrt(gradient_x * gradient_x + gradient_y * gradient_y);
+        return (gradient_x * norm) * fraction_x + (gradient_y * norm) * fraction_y;
+    };
+    const Value noise_00 = corner(cell_x0, cell_y0, fraction_x0, fraction_y0);
+    const Value noise_10 = corner(cell_x1, cell_y0, fraction_x1, fraction_y0);
+    const Value noise_01 = corner(cell_x0, cell_y1, fraction_x0, fraction_y1);
+    const Value noise_11 = corner(cell_x1, cell_y1, fraction_x1, fraction_y1);
+
+    // Blend the contributions along x and then along y
+    const Value fade_x = detail::fade(fraction_x0);
+    const Value fade_y = detail::fade(fraction_y0);
+    const Value noise_x0 = detail::mix(noise_00, noise_10, fade_x);
+    const Value noise_x1 = detail::mix(noise_01, noise_11, fade_x);
+    return Value{2.3f} * detail::mix(noise_x0, noise_x1, fade_y);
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "gridmesh.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "hermite.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+
+// Indices of the 2 triangles of each quad between the vertex rows i and i + 1
+void write_quad_indices(std::size_t i, std::size_t columns, std::uint32_t* index)
+{
+    const auto row_start = static_cast<std::uint32_t>(i * columns);
+    for (std::uint32_t j = 0; j + 1 < columns; ++j)
+    {
+        const std::uint32_t top = row_start + j;
+        const std::uint32_t bottom = top + static_cast<std::uint32_t>(columns);
+
+        // Upper triangle of the quad
+        index[0] = top;
+        index[1] = bottom + 1;
+        index[2] = top + 1;
+
+        // Lower triangle of the quad
+        index[3] = top;
+        index[4] = bottom;
+        index[5] = bottom + 1;
+        index += 6;
+    }
+}
+
+} // namespace
+
+std::size_t grid_mesh_vertex_values(int width, int height)
+{
+    return grid_mesh_attributes * static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+}
+
+std::size_t grid_mesh_index_count(int width, int height)
+{
+    // 2 triangles per square, 3 indices per triangle
+    return 6 * static_cast<std::size_t>(std::max(width - 1, 0)) * static_cast<std::size_t>(std::max(height - 1, 0));
+}
+
+std::pair<std::vector<float>, std::vector<std::uint32_t>> grid_mesh(int width, int height, ImageView<float> height_map,
+                                                                    const CubicHermiteCurve& curve,
+                                                                    std::size_t workers)
+{
+    std::vector<float> vertices_data(grid_mesh_vertex_values(width, height));
+    std::vector<std::uint32_t> indices(grid_mesh_index_count(width, height));
+    build_grid_mesh(width, height, height_map, curve, vertices_data, indices, workers);
+    return {std::move(vertices_data), std::move(indices)};
+}
+
+void build_grid_mesh(int width, int height, ImageView<float> height_map, const CubicHermiteCurve& curve,
+                     std::span<float> vertices, std::span<std::uint32_t> indices, std::size_t workers)
+{
+    assert(height_map.width() >= static_cast<std::size_t>(width) &&
+           height_map.height() >= static_cast<std::size_t>(height));
+    assert(vertices.size() == grid_mesh_vertex_values(width, height));
+    assert(indices.size() == grid_mesh_index_count(width, height));
+
+    const auto columns = static_cast<std::size_t>(width);
+    parallel_for_bands(static_cast<std::size_t>(height), workers,
+                       [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        // The curve is evaluated for a whole row at once
+        std::vector<float> heights(columns);
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            curve.evaluate(std::span<const float>{height_map.row(i), columns}, heights);
+            float* vertex = vertices.data() + i * columns * grid_mesh_attributes;
+            const float z = static_cast<float>(i) - static_cast<float>(height) / 2.0f;
+            const float v = static_cast<float>(i) / height;
+            for (std::size_t j = 0; j < columns; ++j)
+            {
+                assert(heights[j] >= 0.0f);
+                vertex[0] = static_cast<float>(j) - static_cast<float>(width) / 2.0f; // x-coordinate
+                vertex[1] = 15.0f * heights[j];                                        // y-coordinate
+                vertex[2] = z;                                                         // z-coordinate
+                vertex[3] = static_cast<float>(j) / width;                             // U-texture coordinate
+                vertex[4] = v;                                                         // V-texture coordinate
+                vertex += grid_mesh_attributes;
+            }
+
+            // The quads below the last row don't exist
+            if (i + 1 == static_cast<std::size_t>(height))
+            {
+                continue;
+            }
+            write_quad_indices(i, columns, indices.data() + i * (columns - 1) * 6);
+        }
+    });
+}
+
+std::pair<std::vector<std::uint16_t>, std::vector<std::uint32_t>> compact_grid_mesh(int width, int height,
+                                                                                    ImageView<float> height_map,
+                                                                                    const CubicHermiteCurve& curve,
+                                                                                    std::size_t workers)
+{
+    std::vector<std::uint16_t> heights(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+    std::vector<std::uint32_t> indices(grid_mesh_index_count(width, height));
+    build_grid_heights(width, height, height_map, curve, heights, workers);
+    build_grid_indices(width, height, indices, workers);
+    return {std::move(heights), std::move(indices)};
+}
+
+void build_grid_heights(int width, int height, ImageView<float> height_map, const CubicHermiteCurve& curve,
+                        std::span<std::uint16_t> heights, std::size_t workers)
+{
+    assert(height_map.width() >= static_cast<std::size_t>(width) &&
+           height_map.height() >= static_cast<std::size_t>(height));
+    assert(heights.size() == static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+
+    const auto columns = static_cast<std::size_t>(width);
+    parallel_for_bands(static_cast<std::size_t>(height), workers,
+                       [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        std::vector<float> row_heights(columns);
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            curve.evaluate(std::span<const float>{height_map.row(i), columns}, row_heights);
+            quantize(ImageView<float>{row_heights.data(), columns, 1, 1, columns},
+                     MutableImageView<std::uint16_t>{heights.data() + i * columns, columns, 1, 1, columns});
+        }
+    });
+}
+
+void build_grid_indices(int width, int height, std::span<std::uint32_t> indices, std::size_t workers)
+{
+    assert(indices.size() == grid_mesh_index_count(width, height));
+    const auto columns = static_cast<std::size_t>(width);
+    parallel_for_bands(static_cast<std::size_t>(std::max(height - 1, 0)), workers,
+                       [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            write_quad_indices(i, columns, indices.data() + i * (columns - 1) * 6);
+        }
+    });
+}
+
+std::vector<float> grid_patch_vertices(int width, int height, int number_of_patches)
+{
+    std::vector<float> vertices_data;
+    const int number_of_attributes{5};
+    const int vertices_per_patch{4};
+    vertices_data.reserve(number_of_patches * number_of_patches * number_of_attributes * vertices_per_patch);
+
+    const float half_width = static_cast<float>(width) / 2.0f;
+    const float horizontal_ratio = static_cast<float>(width) / static_cast<float>(number_of_patches);
+    const float half_height = static_cast<float>(height) / 2.0f;
+    const float vertical_ratio = static_cast<float>(height) / static_cast<float>(number_of_patches);
+    for (int x = 0; x < number_of_patches; ++x)
+    {
+        for (int z = 0; z < number_of_patches; ++z)
+        {
+            /*
+            Note:
+            A (input) quad with vertices [0, 1, 2, 3] is mapped to the
+            abstract patch with vertices [p00, p10, p11, p01], respectively.
+            Also note that when looking down the Y-axis, Z points down and X points
+            right, while the parametric space has U pointing right and V pointing up.
+            3--------2       p01------p11
+            |        |        |        |
+            |        |   ~    |        |
+            |        |        |        |
+            0--------1       p00------p10
+            */
+            vertices_data.emplace_back(x * horizontal_ratio - half_width);             // x-coordinate
+            vertices_data.emplace_back(0.0f);                                          // y-coordinate
+            vertices_data.emplace_back((z + 1) * vertical_ratio - half_height);        // z-coordinate
+            vertices_data.emplace_back(static_cast<float>(x) / number_of_patches);     // u-coordinate
+            vertices_data.emplace_back(static_cast<float>(z + 1) / number_of_patches); // v-coordinate
+
+            vertices_data.emplace_back((x + 1) * horizontal_ratio - half_width);       // x-coordinate
+            vertices_data.emplace_back(0.0f);                                          // y-coordinate
+            vertices_data.emplace_back((z + 1) * vertical_ratio - half_height);        // z-coordinate
+            vertices_data.emplace_back(static_cast<float>(x + 1) / number_of_patches); // u-coordinate
+            vertices_data.emplace_back(static_cast<float>(z + 1) / number_of_patches); // v-coordinate
+
+            vertices_data.emplace_back((x + 1) * horizontal_ratio - half_width);       // x-coordinate
+            vertices_data.emplace_back(0.0f);                                          // y-coordinate
+            vertices_data.emplace_back(z * vertical_ratio - half_height);              // z-coordinate
+            vertices_data.emplace_back(static_cast<float>(x + 1) / number_of_patches); // u-coordinate
+            vertices_data.emplace_back(static_cast<float>(z) / number_of_patches);     // v-coordinate
+
+            vertices_data.emplace_back(x * horizontal_ratio - half_width);         // x-coordinate
+            vertices_data.emplace_back(0.0f);                                      // y-coordinate
+            vertices_data.emplace_back(z * vertical_ratio - half_height);          // z-coordinate
+            vertices_data.emplace_back(static_cast<float>(x) / number_of_patches); // u-coordinate
+            vertices_data.emplace_back(static_cast<float>(z) / number_of_patches); // v-coordinate
+        }
+    }
+
+    return vertices_data;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef GRID_MESH_HPP
+#define GRID_MESH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "image.hpp"
+#include "imageview.hpp"
+
+class CubicHermiteCurve;
+
+// Values per vertex of grid_mesh: position (3) and texture coordinates (2)
+inline constexpr std::size_t grid_mesh_attributes{5};
+
+// Exact sizes of the buffers of a width x height grid mesh: floats of the vertices and number of indices
+std::size_t grid_mesh_vertex_values(int width, int height);
+std::size_t grid_mesh_index_count(int width, int height);
+
+/*
+Vertices (position and texture coordinates, interleaved) and triangle
+indices of a width x height grid centered at the origin, with heights
+taken from height_map and remapped through curve. Doesn't depend on
+OpenGL, so it can be used by headless tools.
+*/
+std::pair<std::vector<float>, std::vector<std::uint32_t>> grid_mesh(int width, int height, ImageView<float> height_map,
+                                                                    const CubicHermiteCurve& curve,
+                                                                    std::size_t workers = 1);
+
+/*
+Same, written into buffers of exactly grid_mesh_vertex_values and
+grid_mesh_index_count elements provided by the caller (e.g. a mapped
+vertex buffer), without allocating them. The rows are split in bands
+across workers (0 for one worker per hardware thread), each band writing
+its own vertex and index ranges.
+*/
+void build_grid_mesh(int width, int height, ImageView<float> height_map, const CubicHermiteCurve& curve,
+                     std::span<float> vertices, std::span<std::uint32_t> indices, std::size_t workers = 1);
+
+/*
+Compact grid mesh for vertex pulling: each vertex only stores its height
+remapped through curve, as a 16-bit unsigned normalized integer (2 bytes
+instead of the 20 of grid_mesh), and the indices are those of grid_mesh.
+The vertex shader derives the position and texture coordinates from
+gl_VertexID, which is the index i * width + j of the vertex, and the grid
+size (see assets/shaders/cpu_terrain/vertex_shader.vs). Heights are
+clamped to [0, 1] and quantized like quantize.
+
+The grid can also be drawn without any vertex data, as
+grid_mesh_index_count(width, height) non-indexed vertices whose position
+is derived from gl_VertexID and whose height is read from a height map
+texture (ATTRIBUTELESS_VERTICES in the same shader).
+*/
+std::pair<std::vector<std::uint16_t>, std::vector<std::uint32_t>> compact_grid_mesh(int width, int height,
+                                                                                    ImageView<float> height_map,
+                                                                                    const CubicHermiteCurve& curve,
+                                                                                    std::size_t workers = 1);
+
+// The two buffers of compact_grid_mesh, written into width * height heights and grid_mesh_index_count indices
+void build_grid_heights(int width, int height, ImageView<float> height_map, const CubicHermiteCurve& curve,
+                        std::span<std::uint16_t> heights, std::size_t workers = 1);
+void build_grid_indices(int width, int height, std::span<std::uint32_t> indices, std::size_t workers = 1);
+
+/*
+Vertices of number_of_patches x number_of_patches quad patches (4 vertices
+each, with position and texture coordinates) covering a width x height
+plane centered at the origin, as used by the tessellated terrain.
+*/
+std::vector<float> grid_patch_vertices(int width, int height, int number_of_patches);
+
+#endif // GRID_MESH_HPP
\ No newline at end of file
@@ -6,7 +6,48 @@
 CubicHermiteCurve::CubicHermiteCurve(std::vector<glm::vec2> points, std::vector<glm::vec2> tangents, std::vector<float> ranges):
     points_{std::move(points)}, tangents_{std::move(tangents)}, ranges_{std::move(ranges)}
 {
-    assert(std::is_sorted(ranges.cbegin(), ranges.cend()));
+    assert(std::is_sorted(ranges_.cbegin(), ranges_.cend()));
+    assert(ranges_.size() >= 2);
+    assert(points_.size() == ranges_.size());
+    assert(tangents_.size() == ranges_.size());
+
+    // Expand p(s) = h00(s) p0 + h10(s) t0 + h01(s) p1 + h11(s) t1 into powers of s
+    segments_.reserve(ranges_.size() - 1);
+    for (std::size_t i = 1; i < ranges_.size(); ++i)
+    {
+        const glm::vec2 start_point{points_[i - 1]};
+        const glm::vec2 end_point{points_[i]};
+        const glm::vec2 start_tangent{tangents_[i - 1]};
+        const glm::vec2 end_tangent{tangents_[i]};
+        segments_.push_back(Segment{
+            .start = ranges_[i - 1],
+            .inverse_width = 1.0f / (ranges_[i] - ranges_[i - 1]),
+            .coefficients =
+                {
+                    start_point,
+                    start_tangent,
+                    3.0f * (end_point - start_point) - 2.0f * start_tangent - end_tangent,
+                    2.0f * (start_point - end_point) + start_tangent + end_tangent,
+                },
+        });
+    }
+    breakpoints_.assign(ranges_.cbegin() + 1, ranges_.cend() - 1);
+}
+
+/*
+The segment of a parameter is the number of inner ranges it reaches, as
+with std::upper_bound, except that the last range belongs to the last
+segment. Counting them has no data-dependent branch, which matters since
+heights fall on random segments.
+*/
+const CubicHermiteCurve::Segment& CubicHermiteCurve::segment(float parameter) const
+{
+    std::size_t index{0};
+    for (const float breakpoint : breakpoints_)
+    {
+        index += static_cast<std::size_t>(parameter >= breakpoint);
+    }
+    return segments_[index];
 }
 
 glm::vec2 CubicHermiteCurve::evaluate(float parameter) const
@@ -14,19 +55,46 @@ glm::vec2 CubicHermiteCurve::evaluate(float parameter) const
     assert(parameter >= ranges_.front());
     assert(parameter <= ranges_.back());
 
-    std::size_t curve_index{0};
-    if (parameter == ranges_.front())
+    const Segment& curve = segment(parameter);
+    const float scaled_parameter{(parameter - curve.start) * curve.inverse_width};
+    return curve.coefficients[0] +
+           scaled_parameter * (curve.coefficients[1] +
+                               scaled_parameter * (curve.coefficients[2] + scaled_parameter * curve.coefficients[3]));
+}
+
+void CubicHermiteCurve::evaluate(std::span<const float> parameters, std::span<float> heights) const
+{
+    assert(parameters.size() == heights.size());
+    for (std::size_t i = 0; i < parameters.size(); ++i)
     {
-        curve_index = 1;
+        const float parameter{parameters[i]};
+        assert(parameter >= ranges_.front());
+        assert(parameter <= ranges_.back());
+
+        const Segment& curve = segment(parameter);
+        const float scaled_parameter{(parameter - curve.start) * curve.inverse_width};
+        heights[i] = curve.coefficients[0].y +
+                     scaled_parameter * (curve.coefficients[1].y +
+                                         scaled_parameter * (curve.coefficients[2].y +
+                                                             scaled_parameter * curve.coefficients[3].y));
     }
-    else
+}
+
+const std::vector<float>& CubicHermiteCurve::ranges() const
+{
+    return ranges_;
+}
+
+std::vector<glm::vec4> CubicHermiteCurve::height_coefficients() const
+{
+    std::vector<glm::vec4> coefficients;
+    coefficients.reserve(segments_.size());
+    for (const Segment& curve : segments_)
     {
-        auto search_iterator = std::upper_bound(ranges_.cbegin(), ranges_.cend(), parameter);
-        curve_index = (search_iterator == ranges_.cend() ? ranges_.size() - 1: search_iterator - ranges_.cbegin());
+        coefficients.emplace_back(curve.coefficients[0].y, curve.coefficients[1].y, curve.coefficients[2].y,
+                                  curve.coefficients[3].y);
     }
-
-    const float scaled_parameter = (parameter - ranges_[curve_index - 1]) / (ranges_[curve_index] - ranges_[curve_index - 1]);
-    return cubic_hermite_interpolation(points_[curve_index - 1], points_[curve_index], tangents_[curve_index - 1], tangents_[curve_index], scaled_parameter);
+    return coefficients;
 }
 
 glm::vec2 cubic_hermite_interpolation(glm::vec2 start_point, glm::vec2 end_point, glm::vec2 start_tangent, glm::vec2 end_tangent, float parameter)
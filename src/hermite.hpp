@@ -2,6 +2,7 @@
 #define HERMITE_HPP
 
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 class CubicHermiteCurve
@@ -24,11 +25,38 @@ public:
     CubicHermiteCurve& operator=(CubicHermiteCurve&&) noexcept = default;
     ~CubicHermiteCurve() = default;
 
+    /*
+    The curves are baked on construction into per-segment polynomials in
+    power basis, so evaluation is a branchless segment lookup followed by
+    two Horner evaluations. The power basis is an exact re-expansion of the
+    Hermite basis, so the results match cubic_hermite_interpolation up to
+    float rounding (a few ulp of the largest point or tangent coordinate).
+    */
     glm::vec2 evaluate(float parameter) const;
+
+    // Height (y coordinate) of the curve at every parameter; both spans must have the same size
+    void evaluate(std::span<const float> parameters, std::span<float> heights) const;
+
+    const std::vector<float>& ranges() const;
+    // Coefficients of s^0 to s^3 of the height of each segment, s in [0, 1], e.g. for GPU evaluation
+    std::vector<glm::vec4> height_coefficients() const;
 private:
+    // Segment i covers [start, start + 1 / inverse_width] with coefficients of s^0 to s^3, s in [0, 1]
+    struct Segment
+    {
+        float start;
+        float inverse_width;
+        glm::vec2 coefficients[4];
+    };
+
     std::vector<glm::vec2> points_;
     std::vector<glm::vec2> tangents_;
     std::vector<float> ranges_;
+    std::vector<Segment> segments_;
+    // Ranges between the first and the last one, where the segment changes
+    std::vector<float> breakpoints_;
+
+    const Segment& segment(float parameter) const;
 };
 
 glm::vec2 cubic_hermite_interpolation(glm::vec2 start_point, glm::vec2 end_point, glm::vec2 start_tangent, glm::vec2 end_tangent, float parameter);
@@ -1,42 +1,198 @@
 #include "image.hpp"
 
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stb_image_write.h>
 
-void save_image(std::string_view filename, const Image<std::uint8_t>& image)
+#include "parallel.hpp"
+#include "simd.hpp"
+
+namespace
 {
-    stbi_write_png(filename.data(), static_cast<int>(image.width()), static_cast<int>(image.height()),
-                   static_cast<int>(image.depth()), image.data(), static_cast<int>(image.width() * image.depth()));
+
+using Batch = simd::NativeFloatBatch;
+using simd::max;
+using simd::min;
+
+// Invoke function(source_row, destination_row, values) for every row, splitting the rows in bands across workers
+template<typename Source, typename Destination, typename Function>
+void for_each_row(ImageView<Source> source, MutableImageView<Destination> destination, std::size_t workers,
+                  Function&& function)
+{
+    assert(source.width() == destination.width() && source.height() == destination.height() &&
+           source.depth() == destination.depth());
+    const std::size_t values{source.width() * source.depth()};
+    parallel_for_bands(source.height(), workers, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            function(source.row(i), destination.row(i), values);
+        }
+    });
 }
 
-void normalize_image(Image<float>& image)
+void min_max_row(const float* values, std::size_t count, float& min_value, float& max_value)
 {
-    normalize_image(image, image.max(), image.min());
+    std::size_t j{0};
+    if (count >= Batch::lanes)
+    {
+        Batch batch_min = Batch::load(values);
+        Batch batch_max = batch_min;
+        for (j = Batch::lanes; j + Batch::lanes <= count; j += Batch::lanes)
+        {
+            const Batch batch = Batch::load(values + j);
+            batch_min = min(batch_min, batch);
+            batch_max = max(batch_max, batch);
+        }
+        min_value = min(min_value, horizontal_min(batch_min));
+        max_value = max(max_value, horizontal_max(batch_max));
+    }
+    for (; j < count; ++j)
+    {
+        min_value = min(min_value, values[j]);
+        max_value = max(max_value, values[j]);
+    }
 }
 
-void normalize_image(Image<float>& image, float max, float min)
+void normalize_row(float* values, std::size_t count, float min_value, float range)
 {
-    const float range{max - min};
-    for (float& value : image)
+    const Batch batch_min{min_value};
+    const Batch batch_range{range};
+    std::size_t j{0};
+    for (; j + Batch::lanes <= count; j += Batch::lanes)
+    {
+        ((Batch::load(values + j) - batch_min) / batch_range).store(values + j);
+    }
+    for (; j < count; ++j)
     {
-        value = (value - min) / range;
+        values[j] = (values[j] - min_value) / range;
     }
 }
 
-Image<std::uint8_t> from_float_to_uint8(const Image<float>& image)
+template<typename Integer>
+void quantize_row(const float* source, Integer* destination, std::size_t count)
 {
-    Image<std::uint8_t> new_image(image.width(), image.height(), image.depth());
-    for (std::size_t i = 0; i < image.height(); ++i)
+    constexpr float scale{static_cast<float>(std::numeric_limits<Integer>::max())};
+    const Batch zero{0.0f};
+    const Batch one{1.0f};
+    const Batch batch_scale{scale};
+    std::array<std::int32_t, Batch::lanes> integers;
+    std::size_t j{0};
+    for (; j + Batch::lanes <= count; j += Batch::lanes)
     {
-        for (std::size_t j = 0; j < image.width(); ++j)
+        (min(max(Batch::load(source + j), zero), one) * batch_scale).store_truncated(integers.data());
+        for (std::size_t lane = 0; lane < Batch::lanes; ++lane)
+        {
+            destination[j + lane] = static_cast<Integer>(integers[lane]);
+        }
+    }
+    for (; j < count; ++j)
+    {
+        destination[j] = static_cast<Integer>(min(max(source[j], 0.0f), 1.0f) * scale);
+    }
+}
+
+void half_row(const float* source, std::uint16_t* destination, std::size_t count)
+{
+    std::size_t j{0};
+    for (; j + Batch::lanes <= count; j += Batch::lanes)
+    {
+        simd::store_half(Batch::load(source + j), destination + j);
+    }
+    for (; j < count; ++j)
+    {
+        destination[j] = simd::to_half(source[j]);
+    }
+}
+
+} // namespace
+
+void save_image(std::string_view filename, ImageView<std::uint8_t> image)
+{
+    stbi_write_png(filename.data(), static_cast<int>(image.width()), static_cast<int>(image.height()),
+                   static_cast<int>(image.depth()), image.data(), static_cast<int>(image.pitch()));
+}
+
+std::pair<float, float> min_max(ImageView<float> image, std::size_t workers)
+{
+    // Each band reduces its own range, which are merged after all bands finish
+    std::vector<std::pair<float, float>> band_ranges(
+        band_count(image.height(), workers),
+        {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()});
+    const std::size_t values{image.width() * image.depth()};
+    parallel_for_bands(image.height(), workers, [&](std::size_t band, std::size_t first_row, std::size_t last_row) {
+        auto& [min_value, max_value] = band_ranges[band];
+        for (std::size_t i = first_row; i < last_row; ++i)
         {
-            for (std::size_t k = 0; k < image.depth(); ++k)
-            {
-                new_image.set(i, j, k, static_cast<std::uint8_t>(255.0f * image.get(i, j, k)));
-            }
+            min_max_row(image.row(i), values, min_value, max_value);
         }
+    });
+
+    std::pair<float, float> range{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+    for (const auto& [band_min, band_max] : band_ranges)
+    {
+        range.first = min(range.first, band_min);
+        range.second = max(range.second, band_max);
     }
+    return range;
+}
+
+void normalize_image(Image<float>& image, std::size_t workers)
+{
+    const auto [min_value, max_value] = min_max(image, workers);
+    normalize_image(image, max_value, min_value, workers);
+}
+
+void normalize_image(Image<float>& image, float max, float min, std::size_t workers)
+{
+    const float range{max - min};
+    const std::size_t values{image.width() * image.depth()};
+    parallel_for_bands(image.height(), workers, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            normalize_row(image.row(i), values, min, range);
+        }
+    });
+}
+
+void quantize(ImageView<float> source, MutableImageView<std::uint8_t> destination, std::size_t workers)
+{
+    for_each_row(source, destination, workers, quantize_row<std::uint8_t>);
+}
+
+void quantize(ImageView<float> source, MutableImageView<std::uint16_t> destination, std::size_t workers)
+{
+    for_each_row(source, destination, workers, quantize_row<std::uint16_t>);
+}
+
+void convert_to_half(ImageView<float> source, MutableImageView<std::uint16_t> destination, std::size_t workers)
+{
+    for_each_row(source, destination, workers, half_row);
+}
+
+Image<std::uint8_t> from_float_to_uint8(const Image<float>& image, std::size_t workers)
+{
+    Image<std::uint8_t> new_image(image.width(), image.height(), image.depth());
+    quantize(image, new_image.mutable_view(), workers);
+    return new_image;
+}
+
+Image<std::uint16_t> from_float_to_uint16(const Image<float>& image, std::size_t workers)
+{
+    Image<std::uint16_t> new_image(image.width(), image.height(), image.depth());
+    quantize(image, new_image.mutable_view(), workers);
+    return new_image;
+}
+
+Image<std::uint16_t> from_float_to_half(const Image<float>& image, std::size_t workers)
+{
+    Image<std::uint16_t> new_image(image.width(), image.height(), image.depth());
+    convert_to_half(image, new_image.mutable_view(), workers);
     return new_image;
 }
\ No newline at end of file
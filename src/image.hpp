@@ -1,24 +1,87 @@
 #ifndef IMAGE_HPP
 #define IMAGE_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <new>
+#include <optional>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "imageview.hpp"
+#include "mappedfile.hpp"
+
+// Alignment, in bytes, of the storage of every Image and of the rows of padded images
+inline constexpr std::size_t image_alignment{64};
+
+// Allocator of storage aligned to image_alignment, so kernels can use aligned SIMD loads
+template<typename T>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{image_alignment}));
+    }
+
+    void deallocate(T* pointer, std::size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t{image_alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+// Layout of the rows of an image: contiguous, or each one padded to a multiple of image_alignment bytes
+enum class RowPadding
+{
+    none,
+    aligned
+};
+
 /* 
 Class representing 3D image data stored using an interleaved
 format (e.g. RGBRGB or RGBARGBA).
+
+Rows are pitch() values apart. By default rows are contiguous (pitch is
+width * depth); with RowPadding::aligned every row starts on a 64-byte
+boundary, so SIMD kernels can process whole rows with aligned loads and
+stores. Element accessors, transform, min and max skip the padding,
+whereas begin/end and data() expose the whole storage.
+
+Images are stored in memory, or in a memory-mapped file for maps larger
+than the physical memory (e.g. a 32k x 32k float height map). The file
+holds the rows as they are laid out in memory, without a header, and is
+kept when the image is destroyed. Copies of a file-backed image are
+stored in memory, except when assigning to an image of the same layout,
+which copies the values into its existing storage.
 */
 template<typename T>
 class Image
 {
 public:
-    Image(std::size_t width, std::size_t height, std::size_t depth = 1);
+    Image(std::size_t width, std::size_t height, std::size_t depth = 1, RowPadding padding = RowPadding::none);
+    // File-backed image; an existing file of the right size keeps its values, a new one is zero-filled
+    Image(const std::filesystem::path& file, std::size_t width, std::size_t height, std::size_t depth = 1,
+          RowPadding padding = RowPadding::none);
 
-    Image(const Image&) = default;
-    Image(Image&&) noexcept = default;
-    Image& operator=(const Image&) = default;
-    Image& operator=(Image&&) noexcept = default;
+    Image(const Image& other);
+    Image(Image&& other) noexcept;
+    Image& operator=(const Image& other);
+    Image& operator=(Image&& other) noexcept;
     ~Image() = default;
 
     T get(std::size_t i, std::size_t j, std::size_t k = 0) const;
@@ -32,7 +95,15 @@ public:
     template<typename Function>
     void transform(Function && function);
     
+    T* data();
     const T* data() const;
+    T* row(std::size_t i);
+    const T* row(std::size_t i) const;
+
+    ImageView<T> view() const;
+    MutableImageView<T> mutable_view();
+    operator ImageView<T>() const;
+
     auto begin();
     auto end();
     auto cbegin() const;
@@ -42,26 +113,69 @@ public:
     std::size_t height() const;
     std::size_t depth() const;
     std::size_t pixels() const;
+    std::size_t pitch() const;
+    bool is_contiguous() const;
+    bool is_mapped() const;
+    // File holding a file-backed image, nullopt for an image in memory
+    std::optional<std::filesystem::path> file() const;
+
+    // Hint about the upcoming accesses to a file-backed image; ignored for images in memory
+    void advise(AccessPattern pattern) const;
+
     T max() const;
     T min() const;
 private:
     std::size_t width_{0};
     std::size_t height_{0};
     std::size_t depth_{1};
-    std::vector<T> image_data_;
+    std::size_t pitch_{0};
+    std::vector<T, AlignedAllocator<T>> image_data_;
+    std::optional<MappedFile> file_;
+    T* data_{nullptr};
 };
 
-void save_image(std::string_view filename, const Image<std::uint8_t>& image);
+void save_image(std::string_view filename, ImageView<std::uint8_t> image);
+
+/*
+The image kernels below make a single vectorized pass over the image and
+split its rows in bands across workers (0 for one worker per hardware
+thread), like the generator.
+*/
+
+// Smallest and largest values of the image, in one pass
+std::pair<float, float> min_max(ImageView<float> image, std::size_t workers = 1);
 
 /* 
 Normalize grayscale floating-point image. 
 If there's more than one image channel, assumes that
 all channels are equal (e.g. for a RGB image, R = G = B).
 */
-void normalize_image(Image<float>& image);
-void normalize_image(Image<float>& image, float max, float min);
+void normalize_image(Image<float>& image, std::size_t workers = 1);
+void normalize_image(Image<float>& image, float max, float min, std::size_t workers = 1);
+
+/*
+Quantize values in [0, 1] (values outside are clamped) to the full range
+of 8 or 16-bit unsigned integers, rounding toward zero. The destination
+has the size and depth of the source.
+*/
+void quantize(ImageView<float> source, MutableImageView<std::uint8_t> destination, std::size_t workers = 1);
+void quantize(ImageView<float> source, MutableImageView<std::uint16_t> destination, std::size_t workers = 1);
+
+// Convert to IEEE half-precision floats (stored as their bits), rounding to nearest even
+void convert_to_half(ImageView<float> source, MutableImageView<std::uint16_t> destination, std::size_t workers = 1);
 
-Image<std::uint8_t> from_float_to_uint8(const Image<float>& image);
+Image<std::uint8_t> from_float_to_uint8(const Image<float>& image, std::size_t workers = 1);
+Image<std::uint16_t> from_float_to_uint16(const Image<float>& image, std::size_t workers = 1);
+Image<std::uint16_t> from_float_to_half(const Image<float>& image, std::size_t workers = 1);
+
+/*
+Copy the channels of source to destination, an image of the same size.
+Destination channels missing from the source are set to fill (e.g. an
+opaque alpha when expanding RGB to RGBA) and source channels missing from
+the destination are dropped (e.g. packing RGBA into RG).
+*/
+template<typename T>
+void convert_channels(ImageView<T> source, MutableImageView<T> destination, T fill = T{}, std::size_t workers = 1);
 
 #include "image.inl"
 
@@ -3,19 +3,99 @@
 #include <algorithm>
 #include <cassert>
 #include <type_traits>
+#include <utility>
+
+#include "parallel.hpp"
+
+namespace image_detail
+{
+
+// Values per row, rounded up so rows span whole multiples of image_alignment bytes when padded
+template<typename T>
+std::size_t row_pitch(std::size_t width, std::size_t depth, RowPadding padding)
+{
+    static_assert(image_alignment % sizeof(T) == 0);
+    if (padding == RowPadding::none)
+    {
+        return width * depth;
+    }
+    constexpr std::size_t pixels_per_line{image_alignment / sizeof(T)};
+    return (width + pixels_per_line - 1) / pixels_per_line * pixels_per_line * depth;
+}
+
+} // namespace image_detail
 
 template<typename T>
-Image<T>::Image(std::size_t width, std::size_t height, std::size_t depth):
-    width_{width}, height_{height}, depth_{depth}, image_data_(width * height * depth)
+Image<T>::Image(std::size_t width, std::size_t height, std::size_t depth, RowPadding padding):
+    width_{width}, height_{height}, depth_{depth}, pitch_{image_detail::row_pitch<T>(width, depth, padding)},
+    image_data_(pitch_ * height), data_{image_data_.data()}
 {
     static_assert(std::is_arithmetic_v<T>, "ImageTexture underlying type must be numeric");
 }
 
+template<typename T>
+Image<T>::Image(const std::filesystem::path& file, std::size_t width, std::size_t height, std::size_t depth,
+                RowPadding padding):
+    width_{width}, height_{height}, depth_{depth}, pitch_{image_detail::row_pitch<T>(width, depth, padding)},
+    file_{std::in_place, file, pitch_ * height * sizeof(T)}, data_{reinterpret_cast<T*>(file_->data())}
+{
+    static_assert(std::is_arithmetic_v<T>, "ImageTexture underlying type must be numeric");
+}
+
+template<typename T>
+Image<T>::Image(const Image& other):
+    width_{other.width_}, height_{other.height_}, depth_{other.depth_}, pitch_{other.pitch_},
+    image_data_(other.data_, other.data_ + other.pitch_ * other.height_), data_{image_data_.data()}
+{
+}
+
+template<typename T>
+Image<T>::Image(Image&& other) noexcept:
+    width_{other.width_}, height_{other.height_}, depth_{other.depth_}, pitch_{other.pitch_},
+    image_data_{std::move(other.image_data_)}, file_{std::move(other.file_)},
+    data_{std::exchange(other.data_, nullptr)}
+{
+    other.file_.reset();
+    other.width_ = other.height_ = other.pitch_ = 0;
+}
+
+template<typename T>
+Image<T>& Image<T>::operator=(const Image& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    if (width_ == other.width_ && height_ == other.height_ && depth_ == other.depth_ && pitch_ == other.pitch_)
+    {
+        std::copy(other.data_, other.data_ + other.pitch_ * other.height_, data_);
+        return *this;
+    }
+    return *this = Image{other};
+}
+
+template<typename T>
+Image<T>& Image<T>::operator=(Image&& other) noexcept
+{
+    if (this != &other)
+    {
+        width_ = std::exchange(other.width_, 0);
+        height_ = std::exchange(other.height_, 0);
+        depth_ = other.depth_;
+        pitch_ = std::exchange(other.pitch_, 0);
+        image_data_ = std::move(other.image_data_);
+        file_ = std::move(other.file_);
+        other.file_.reset();
+        data_ = std::exchange(other.data_, nullptr);
+    }
+    return *this;
+}
+
 template<typename T>
 T Image<T>::get(std::size_t i, std::size_t j, std::size_t k) const
 {
-    std::size_t index = ((i * width_) + j) * depth_ + k;
-    return image_data_[index];
+    std::size_t index = i * pitch_ + j * depth_ + k;
+    return data_[index];
 }
 
 template<typename T>
@@ -23,16 +103,15 @@ template<typename RandomAccessIterator>
 void Image<T>::set(std::size_t i, std::size_t j, RandomAccessIterator begin, RandomAccessIterator end)
 {
     assert(static_cast<std::size_t>(end - begin) == depth_);
-    const std::size_t index = ((i * width_) + j) * depth_;
-    auto iterator = image_data_.begin() + index;
-    std::copy(begin, end, iterator);
+    const std::size_t index = i * pitch_ + j * depth_;
+    std::copy(begin, end, data_ + index);
 }
 
 template<typename T>
 void Image<T>::set(std::size_t i, std::size_t j, std::size_t k, T value)
 {
-    std::size_t index = ((i * width_) + j) * depth_ + k;
-    image_data_[index] = value;
+    std::size_t index = i * pitch_ + j * depth_ + k;
+    data_[index] = value;
 }
 
 template<typename T>
@@ -40,46 +119,90 @@ template<typename RandomAccessIterator, typename Function>
 void Image<T>::set_transform(std::size_t i, std::size_t j, RandomAccessIterator begin, RandomAccessIterator end, Function&& function)
 {
     assert(static_cast<std::size_t>(end - begin) == depth_);
-    const std::size_t index = ((i * width_) + j) * depth_;
-    auto iterator = image_data_.begin() + index;
-    std::transform(begin, end, iterator, function);
+    const std::size_t index = i * pitch_ + j * depth_;
+    std::transform(begin, end, data_ + index, function);
 }
 
 template<typename T>
 template<typename Function>
 void Image<T>::transform(Function&& function)
 {
-    std::transform(image_data_.begin(), image_data_.end(), image_data_.begin(), function);
+    if (is_contiguous())
+    {
+        std::transform(data_, data_ + pitch_ * height_, data_, function);
+        return;
+    }
+    for (std::size_t i = 0; i < height_; ++i)
+    {
+        T* values = row(i);
+        std::transform(values, values + width_ * depth_, values, function);
+    }
+}
+
+template<typename T>
+T* Image<T>::data()
+{
+    return data_;
 }
 
 template<typename T>
 const T* Image<T>::data() const
 {
-    return image_data_.data();
+    return data_;
+}
+
+template<typename T>
+T* Image<T>::row(std::size_t i)
+{
+    return data_ + i * pitch_;
+}
+
+template<typename T>
+const T* Image<T>::row(std::size_t i) const
+{
+    return data_ + i * pitch_;
+}
+
+template<typename T>
+ImageView<T> Image<T>::view() const
+{
+    return ImageView<T>{data_, width_, height_, depth_, pitch_};
+}
+
+template<typename T>
+MutableImageView<T> Image<T>::mutable_view()
+{
+    return MutableImageView<T>{data_, width_, height_, depth_, pitch_};
+}
+
+template<typename T>
+Image<T>::operator ImageView<T>() const
+{
+    return view();
 }
 
 template<typename T>
 auto Image<T>::begin()
 {
-    return image_data_.begin();
+    return data_;
 }
 
 template<typename T>
 auto Image<T>::end()
 {
-    return image_data_.end();
+    return data_ + pitch_ * height_;
 }
 
 template<typename T>
 auto Image<T>::cbegin() const
 {
-    return image_data_.cbegin();
+    return static_cast<const T*>(data_);
 }
 
 template<typename T>
 auto Image<T>::cend() const
 {
-    return image_data_.cend();
+    return static_cast<const T*>(data_ + pitch_ * height_);
 }
 
 template<typename T>
@@ -106,14 +229,159 @@ std::size_t Image<T>::pixels() const
     return width_ * height_ * depth_;
 }
 
+template<typename T>
+std::size_t Image<T>::pitch() const
+{
+    return pitch_;
+}
+
+template<typename T>
+bool Image<T>::is_contiguous() const
+{
+    return pitch_ == width_ * depth_;
+}
+
+template<typename T>
+bool Image<T>::is_mapped() const
+{
+    return file_.has_value();
+}
+
+template<typename T>
+std::optional<std::filesystem::path> Image<T>::file() const
+{
+    if (file_)
+    {
+        return file_->path();
+    }
+    return std::nullopt;
+}
+
+template<typename T>
+void Image<T>::advise(AccessPattern pattern) const
+{
+    if (file_)
+    {
+        file_->advise(pattern);
+    }
+}
+
 template<typename T>
 T Image<T>::max() const
 {
-    return *std::max_element(image_data_.begin(), image_data_.end());
+    if (is_contiguous())
+    {
+        return *std::max_element(data_, data_ + pitch_ * height_);
+    }
+    T result{*row(0)};
+    for (std::size_t i = 0; i < height_; ++i)
+    {
+        result = std::max(result, *std::max_element(row(i), row(i) + width_ * depth_));
+    }
+    return result;
 }
 
 template<typename T>
 T Image<T>::min() const
 {
-    return *std::min_element(image_data_.begin(), image_data_.end());
+    if (is_contiguous())
+    {
+        return *std::min_element(data_, data_ + pitch_ * height_);
+    }
+    T result{*row(0)};
+    for (std::size_t i = 0; i < height_; ++i)
+    {
+        result = std::min(result, *std::min_element(row(i), row(i) + width_ * depth_));
+    }
+    return result;
+}
+
+namespace image_detail
+{
+
+// Channel count known at compile time, so the per-pixel loop is fully unrolled
+template<std::size_t SourceDepth, std::size_t DestinationDepth, typename T>
+void convert_channels_row(const T* source, T* destination, std::size_t width, T fill)
+{
+    for (std::size_t j = 0; j < width; ++j, source += SourceDepth, destination += DestinationDepth)
+    {
+        for (std::size_t k = 0; k < DestinationDepth; ++k)
+        {
+            destination[k] = k < SourceDepth ? source[k] : fill;
+        }
+    }
+}
+
+template<typename T>
+void convert_channels_row(const T* source, std::size_t source_depth, T* destination, std::size_t destination_depth,
+                          std::size_t width, T fill)
+{
+    for (std::size_t j = 0; j < width; ++j, source += source_depth, destination += destination_depth)
+    {
+        for (std::size_t k = 0; k < destination_depth; ++k)
+        {
+            destination[k] = k < source_depth ? source[k] : fill;
+        }
+    }
+}
+
+template<std::size_t SourceDepth, typename T>
+void convert_channels_row(const T* source, T* destination, std::size_t destination_depth, std::size_t width, T fill)
+{
+    switch (destination_depth)
+    {
+    case 1:
+        convert_channels_row<SourceDepth, 1>(source, destination, width, fill);
+        break;
+    case 2:
+        convert_channels_row<SourceDepth, 2>(source, destination, width, fill);
+        break;
+    case 3:
+        convert_channels_row<SourceDepth, 3>(source, destination, width, fill);
+        break;
+    case 4:
+        convert_channels_row<SourceDepth, 4>(source, destination, width, fill);
+        break;
+    default:
+        convert_channels_row(source, SourceDepth, destination, destination_depth, width, fill);
+        break;
+    }
+}
+
+} // namespace image_detail
+
+template<typename T>
+void convert_channels(ImageView<T> source, MutableImageView<T> destination, T fill, std::size_t workers)
+{
+    assert(source.width() == destination.width() && source.height() == destination.height());
+    parallel_for_bands(source.height(), workers, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            const T* source_row = source.row(i);
+            T* destination_row = destination.row(i);
+            switch (source.depth())
+            {
+            case 1:
+                image_detail::convert_channels_row<1>(source_row, destination_row, destination.depth(),
+                                                      source.width(), fill);
+                break;
+            case 2:
+                image_detail::convert_channels_row<2>(source_row, destination_row, destination.depth(),
+                                                      source.width(), fill);
+                break;
+            case 3:
+                image_detail::convert_channels_row<3>(source_row, destination_row, destination.depth(),
+                                                      source.width(), fill);
+                break;
+            case 4:
+                image_detail::convert_channels_row<4>(source_row, destination_row, destination.depth(),
+                                                      source.width(), fill);
+                break;
+            default:
+                image_detail::convert_channels_row(source_row, source.depth(), destination_row, destination.depth(),
+                                                   source.width(), fill);
+                break;
+            }
+        }
+    });
 }
\ No newline at end of file
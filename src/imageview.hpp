@@ -0,0 +1,163 @@
+#ifndef IMAGE_VIEW_HPP
+#define IMAGE_VIEW_HPP
+
+#include <cassert>
+#include <cstddef>
+
+/*
+Non-owning view of interleaved image data whose rows are pitch values
+apart (pitch >= width * depth). Views are cheap to copy and can refer to
+a whole Image or to a rectangle of it (see subview), so tiles and their
+aprons can be handed to kernels without copying. ImageView is read-only,
+MutableImageView allows writes; both are invalidated when the image
+they refer to is destroyed or resized.
+*/
+template<typename T>
+class ImageView
+{
+public:
+    ImageView() = default;
+    ImageView(const T* data, std::size_t width, std::size_t height, std::size_t depth, std::size_t pitch) :
+        data_{data}, width_{width}, height_{height}, depth_{depth}, pitch_{pitch}
+    {
+        assert(pitch_ >= width_ * depth_);
+    }
+
+    T get(std::size_t i, std::size_t j, std::size_t k = 0) const
+    {
+        assert(i < height_ && j < width_ && k < depth_);
+        return data_[i * pitch_ + j * depth_ + k];
+    }
+
+    const T* data() const
+    {
+        return data_;
+    }
+
+    const T* row(std::size_t i) const
+    {
+        assert(i < height_);
+        return data_ + i * pitch_;
+    }
+
+    // View of rows [first_row, first_row + rows) and columns [first_column, first_column + columns)
+    ImageView subview(std::size_t first_row, std::size_t first_column, std::size_t rows, std::size_t columns) const
+    {
+        assert(first_row + rows <= height_ && first_column + columns <= width_);
+        return ImageView{data_ + first_row * pitch_ + first_column * depth_, columns, rows, depth_, pitch_};
+    }
+
+    std::size_t width() const
+    {
+        return width_;
+    }
+
+    std::size_t height() const
+    {
+        return height_;
+    }
+
+    std::size_t depth() const
+    {
+        return depth_;
+    }
+
+    // Number of values between the starts of consecutive rows
+    std::size_t pitch() const
+    {
+        return pitch_;
+    }
+
+    bool is_contiguous() const
+    {
+        return pitch_ == width_ * depth_;
+    }
+
+private:
+    const T* data_{nullptr};
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::size_t depth_{1};
+    std::size_t pitch_{0};
+};
+
+template<typename T>
+class MutableImageView
+{
+public:
+    MutableImageView() = default;
+    MutableImageView(T* data, std::size_t width, std::size_t height, std::size_t depth, std::size_t pitch) :
+        data_{data}, width_{width}, height_{height}, depth_{depth}, pitch_{pitch}
+    {
+        assert(pitch_ >= width_ * depth_);
+    }
+
+    operator ImageView<T>() const
+    {
+        return ImageView<T>{data_, width_, height_, depth_, pitch_};
+    }
+
+    T get(std::size_t i, std::size_t j, std::size_t k = 0) const
+    {
+        assert(i < height_ && j < width_ && k < depth_);
+        return data_[i * pitch_ + j * depth_ + k];
+    }
+
+    void set(std::size_t i, std::size_t j, std::size_t k, T value) const
+    {
+        assert(i < height_ && j < width_ && k < depth_);
+        data_[i * pitch_ + j * depth_ + k] = value;
+    }
+
+    T* data() const
+    {
+        return data_;
+    }
+
+    T* row(std::size_t i) const
+    {
+        assert(i < height_);
+        return data_ + i * pitch_;
+    }
+
+    MutableImageView subview(std::size_t first_row, std::size_t first_column, std::size_t rows,
+                             std::size_t columns) const
+    {
+        assert(first_row + rows <= height_ && first_column + columns <= width_);
+        return MutableImageView{data_ + first_row * pitch_ + first_column * depth_, columns, rows, depth_, pitch_};
+    }
+
+    std::size_t width() const
+    {
+        return width_;
+    }
+
+    std::size_t height() const
+    {
+        return height_;
+    }
+
+    std::size_t depth() const
+    {
+        return depth_;
+    }
+
+    std::size_t pitch() const
+    {
+        return pitch_;
+    }
+
+    bool is_contiguous() const
+    {
+        return pitch_ == width_ * depth_;
+    }
+
+private:
+    T* data_{nullptr};
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::size_t depth_{1};
+    std::size_t pitch_{0};
+};
+
+#endif // IMAGE_VIEW_HPP
\ No newline at end of file
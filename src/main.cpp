@@ -1,4 +1,3 @@
-#include <cstdlib>
 #include <exception>
 #include <iostream>
 
@@ -6,7 +5,6 @@
 
 int main()
 {
-    std::srand(0);
     try
     {
         Application application{1024, 768, "Procedural Terrain Generation"};
@@ -0,0 +1,522 @@
+#include "mapfile.hpp"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+// Map files are written in the byte order of the host, which is checked to be little endian
+static_assert(std::endian::native == std::endian::little, "Map files are little endian");
+
+constexpr std::array<char, 4> map_file_magic{'T', 'M', 'A', 'P'};
+constexpr std::uint32_t map_file_version{1};
+// Magic, version and offset of the directory
+constexpr std::size_t map_file_header_size{16};
+constexpr std::size_t chunk_alignment{64};
+
+std::size_t element_size(MapElement element)
+{
+    switch (element)
+    {
+    case MapElement::uint8:
+        return 1;
+    case MapElement::uint16:
+        return 2;
+    case MapElement::float32:
+        return 4;
+    }
+    throw std::runtime_error("Unknown map element");
+}
+
+/*
+Run-length encoding of a byte sequence. A control byte c < 128 is followed
+by c + 1 literal bytes; a control byte c >= 128 is followed by one byte
+repeated c - 125 times (runs of 3 to 130 bytes).
+*/
+constexpr std::size_t max_literals{128};
+constexpr std::size_t min_run{3};
+constexpr std::size_t max_run{130};
+
+std::size_t run_length(const std::uint8_t* data, std::size_t size)
+{
+    std::size_t length = 1;
+    while (length < size && length < max_run && data[length] == data[0])
+    {
+        ++length;
+    }
+    return length;
+}
+
+void encode_runs(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& output)
+{
+    std::size_t i = 0;
+    while (i < size)
+    {
+        const std::size_t run = run_length(data + i, size - i);
+        if (run >= min_run)
+        {
+            output.push_back(static_cast<std::uint8_t>(run - min_run + 128));
+            output.push_back(data[i]);
+            i += run;
+            continue;
+        }
+
+        const std::size_t first = i;
+        while (i < size && i - first < max_literals && run_length(data + i, size - i) < min_run)
+        {
+            ++i;
+        }
+        output.push_back(static_cast<std::uint8_t>(i - first - 1));
+        output.insert(output.end(), data + first, data + i);
+    }
+}
+
+void decode_runs(const std::uint8_t* data, std::size_t size, std::uint8_t* output, std::size_t output_size)
+{
+    std::size_t i = 0;
+    std::size_t o = 0;
+    while (i < size)
+    {
+        const std::size_t control = data[i++];
+        if (control < 128)
+        {
+            const std::size_t count = control + 1;
+            if (i + count > size || o + count > output_size)
+            {
+                throw std::runtime_error("Corrupt map file chunk");
+            }
+            std::memcpy(output + o, data + i, count);
+            i += count;
+            o += count;
+        }
+        else
+        {
+            const std::size_t count = control - 128 + min_run;
+            if (i >= size || o + count > output_size)
+            {
+                throw std::runtime_error("Corrupt map file chunk");
+            }
+            std::memset(output + o, data[i++], count);
+            o += count;
+        }
+    }
+    if (o != output_size)
+    {
+        throw std::runtime_error("Corrupt map file chunk");
+    }
+}
+
+// Interleave negative and positive differences (0, -1, 1, -2, ...) so small differences have zero high bytes
+template<typename Word>
+Word zigzag(Word difference)
+{
+    const Word sign = static_cast<Word>(difference >> (8 * sizeof(Word) - 1));
+    return static_cast<Word>(static_cast<Word>(difference << 1) ^ static_cast<Word>(0 - sign));
+}
+
+template<typename Word>
+Word unzigzag(Word value)
+{
+    return static_cast<Word>(static_cast<Word>(value >> 1) ^ static_cast<Word>(0 - static_cast<Word>(value & 1)));
+}
+
+/*
+Differences of the chunk values with their left neighbour of the same
+channel (the value above for the first column), computed on the bit
+patterns with wrapping arithmetic so floats round trip exactly. Byte b of
+the zigzag encoded difference i goes to planes[b * count + i].
+*/
+template<typename Word>
+void split_differences(ImageView<std::uint8_t> chunk, std::size_t depth, std::uint8_t* planes)
+{
+    const std::size_t row_values = chunk.width() * chunk.depth() / sizeof(Word);
+    const std::size_t count = row_values * chunk.height();
+    std::vector<Word> previous_row(row_values, Word{0});
+    std::vector<Word> row(row_values);
+    for (std::size_t i = 0; i < chunk.height(); ++i)
+    {
+        std::memcpy(row.data(), chunk.row(i), row_values * sizeof(Word));
+        for (std::size_t j = 0; j < row_values; ++j)
+        {
+            const Word prediction = j >= depth ? row[j - depth] : previous_row[j];
+            const Word difference = zigzag(static_cast<Word>(row[j] - prediction));
+            for (std::size_t b = 0; b < sizeof(Word); ++b)
+            {
+                planes[b * count + i * row_values + j] = static_cast<std::uint8_t>(difference >> (8 * b));
+            }
+        }
+        std::swap(previous_row, row);
+    }
+}
+
+template<typename Word>
+void merge_differences(const std::uint8_t* planes, std::size_t depth, MutableImageView<std::uint8_t> chunk)
+{
+    const std::size_t row_values = chunk.width() * chunk.depth() / sizeof(Word);
+    const std::size_t count = row_values * chunk.height();
+    std::vector<Word> previous_row(row_values, Word{0});
+    std::vector<Word> row(row_values);
+    for (std::size_t i = 0; i < chunk.height(); ++i)
+    {
+        for (std::size_t j = 0; j < row_values; ++j)
+        {
+            Word difference{0};
+            for (std::size_t b = 0; b < sizeof(Word); ++b)
+            {
+                difference = static_cast<Word>(difference | Word(planes[b * count + i * row_values + j]) << (8 * b));
+            }
+            const Word prediction = j >= depth ? row[j - depth] : previous_row[j];
+            row[j] = static_cast<Word>(prediction + unzigzag(difference));
+        }
+        std::memcpy(chunk.row(i), row.data(), row_values * sizeof(Word));
+        std::swap(previous_row, row);
+    }
+}
+
+void encode_chunk(ImageView<std::uint8_t> chunk, MapElement element, std::size_t depth,
+                  std::vector<std::uint8_t>& planes, std::vector<std::uint8_t>& output)
+{
+    planes.resize(chunk.width() * chunk.depth() * chunk.height());
+    switch (element)
+    {
+    case MapElement::uint8:
+        split_differences<std::uint8_t>(chunk, depth, planes.data());
+        break;
+    case MapElement::uint16:
+        split_differences<std::uint16_t>(chunk, depth, planes.data());
+        break;
+    case MapElement::float32:
+        split_differences<std::uint32_t>(chunk, depth, planes.data());
+        break;
+    }
+    output.clear();
+    encode_runs(planes.data(), planes.size(), output);
+}
+
+void decode_chunk(const std::uint8_t* data, std::size_t size, MapElement element, std::size_t depth,
+                  MutableImageView<std::uint8_t> chunk)
+{
+    std::vector<std::uint8_t> planes(chunk.width() * chunk.depth() * chunk.height());
+    decode_runs(data, size, planes.data(), planes.size());
+    switch (element)
+    {
+    case MapElement::uint8:
+        merge_differences<std::uint8_t>(planes.data(), depth, chunk);
+        break;
+    case MapElement::uint16:
+        merge_differences<std::uint16_t>(planes.data(), depth, chunk);
+        break;
+    case MapElement::float32:
+        merge_differences<std::uint32_t>(planes.data(), depth, chunk);
+        break;
+    }
+}
+
+template<typename T>
+void append(std::vector<std::uint8_t>& buffer, T value)
+{
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+// Bounds-checked reader of the directory
+class DirectoryReader
+{
+public:
+    DirectoryReader(const std::byte* data, std::size_t size) : data_{data}, size_{size}
+    {
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value{};
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string read_string(std::size_t size)
+    {
+        const auto* characters = reinterpret_cast<const char*>(take(size));
+        return std::string{characters, characters + size};
+    }
+
+private:
+    const std::byte* data_;
+    std::size_t size_;
+    std::size_t offset_{0};
+
+    const std::byte* take(std::size_t size)
+    {
+        if (size > size_ - offset_)
+        {
+            throw std::runtime_error("Truncated map file directory");
+        }
+        const std::byte* data = data_ + offset_;
+        offset_ += size;
+        return data;
+    }
+};
+
+} // namespace
+
+MapFileWriter::MapFileWriter(const std::filesystem::path& path) :
+    path_{path}, file_{path, std::ios::binary | std::ios::trunc}
+{
+    if (!file_)
+    {
+        throw std::runtime_error("Failure to open " + path.string());
+    }
+    // The header is rewritten by finish, with the offset of the directory
+    const std::array<std::uint8_t, map_file_header_size> header{};
+    write(header.data(), header.size());
+}
+
+void MapFileWriter::add_map(MapInfo info, ImageView<std::uint8_t> bytes, ChunkCompression compression)
+{
+    const std::size_t value_size = element_size(info.element);
+    if (info.chunk_size == 0 || info.width == 0 || info.height == 0 ||
+        info.chunk_size * info.chunk_size * info.depth * value_size > UINT32_MAX || info.width > UINT32_MAX ||
+        info.height > UINT32_MAX || info.depth > UINT32_MAX)
+    {
+        throw std::invalid_argument("Invalid map or chunk size for " + info.name);
+    }
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(info.chunk_rows() * info.chunk_columns());
+    for (std::size_t chunk_row = 0; chunk_row < info.chunk_rows(); ++chunk_row)
+    {
+        for (std::size_t chunk_column = 0; chunk_column < info.chunk_columns(); ++chunk_column)
+        {
+            const ImageView<std::uint8_t> chunk =
+                bytes.subview(chunk_row * info.chunk_size, chunk_column * info.chunk_size,
+                              info.chunk_height(chunk_row), info.chunk_width(chunk_column));
+            const std::size_t row_size = chunk.width() * chunk.depth();
+            const std::size_t raw_size = row_size * chunk.height();
+
+            const std::uint8_t* data = nullptr;
+            Chunk entry{};
+            if (compression == ChunkCompression::delta_rle)
+            {
+                encode_chunk(chunk, info.element, info.depth, chunk_buffer_, encoded_buffer_);
+            }
+            if (compression == ChunkCompression::delta_rle && encoded_buffer_.size() < raw_size)
+            {
+                data = encoded_buffer_.data();
+                entry.size = static_cast<std::uint32_t>(encoded_buffer_.size());
+                entry.compression = ChunkCompression::delta_rle;
+            }
+            else
+            {
+                chunk_buffer_.resize(raw_size);
+                for (std::size_t i = 0; i < chunk.height(); ++i)
+                {
+                    std::memcpy(chunk_buffer_.data() + i * row_size, chunk.row(i), row_size);
+                }
+                data = chunk_buffer_.data();
+                entry.size = static_cast<std::uint32_t>(raw_size);
+            }
+
+            // Align the chunk so views of uncompressed chunks can be used with aligned loads
+            const std::array<std::uint8_t, chunk_alignment> padding{};
+            write(padding.data(), (chunk_alignment - offset_ % chunk_alignment) % chunk_alignment);
+            entry.offset = offset_;
+            write(data, entry.size);
+            chunks.push_back(entry);
+        }
+    }
+    maps_.push_back(std::move(info));
+    chunks_.push_back(std::move(chunks));
+}
+
+void MapFileWriter::finish()
+{
+    std::vector<std::uint8_t> directory;
+    append(directory, static_cast<std::uint32_t>(maps_.size()));
+    for (std::size_t map = 0; map < maps_.size(); ++map)
+    {
+        const MapInfo& info = maps_[map];
+        append(directory, static_cast<std::uint32_t>(info.name.size()));
+        directory.insert(directory.end(), info.name.begin(), info.name.end());
+        append(directory, static_cast<std::uint32_t>(info.element));
+        append(directory, static_cast<std::uint32_t>(info.width));
+        append(directory, static_cast<std::uint32_t>(info.height));
+        append(directory, static_cast<std::uint32_t>(info.depth));
+        append(directory, static_cast<std::uint32_t>(info.chunk_size));
+        for (const Chunk& chunk : chunks_[map])
+        {
+            append(directory, chunk.offset);
+            append(directory, chunk.size);
+            append(directory, static_cast<std::uint32_t>(chunk.compression));
+        }
+    }
+    const std::uint64_t directory_offset = offset_;
+    write(directory.data(), directory.size());
+
+    std::vector<std::uint8_t> header;
+    header.insert(header.end(), map_file_magic.begin(), map_file_magic.end());
+    append(header, map_file_version);
+    append(header, directory_offset);
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    file_.flush();
+    if (!file_)
+    {
+        throw std::runtime_error("Failure to write " + path_.string());
+    }
+}
+
+void MapFileWriter::write(const void* data, std::size_t size)
+{
+    file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!file_)
+    {
+        throw std::runtime_error("Failure to write " + path_.string());
+    }
+    offset_ += size;
+}
+
+MapFile::MapFile(const std::filesystem::path& path) : file_{path}
+{
+    const std::string invalid_file = "Invalid map file " + path.string();
+    if (file_.size() < map_file_header_size ||
+        std::memcmp(file_.data(), map_file_magic.data(), map_file_magic.size()) != 0)
+    {
+        throw std::runtime_error(invalid_file);
+    }
+    DirectoryReader header{file_.data() + map_file_magic.size(), map_file_header_size - map_file_magic.size()};
+    if (header.read<std::uint32_t>() != map_file_version)
+    {
+        throw std::runtime_error(invalid_file + ": unsupported version");
+    }
+    const auto directory_offset = header.read<std::uint64_t>();
+    if (directory_offset < map_file_header_size || directory_offset > file_.size())
+    {
+        throw std::runtime_error(invalid_file);
+    }
+
+    DirectoryReader directory{file_.data() + directory_offset, file_.size() - directory_offset};
+    const auto map_count = directory.read<std::uint32_t>();
+    for (std::uint32_t map = 0; map < map_count; ++map)
+    {
+        MapInfo info{};
+        info.name = directory.read_string(directory.read<std::uint32_t>());
+        const auto element = directory.read<std::uint32_t>();
+        info.width = directory.read<std::uint32_t>();
+        info.height = directory.read<std::uint32_t>();
+        info.depth = directory.read<std::uint32_t>();
+        info.chunk_size = directory.read<std::uint32_t>();
+        if (element > static_cast<std::uint32_t>(MapElement::float32) || info.width == 0 || info.height == 0 ||
+            info.depth == 0 || info.chunk_size == 0)
+        {
+            throw std::runtime_error(invalid_file);
+        }
+        info.element = static_cast<MapElement>(element);
+
+        std::vector<Chunk> chunks(info.chunk_rows() * info.chunk_columns());
+        for (std::size_t chunk_row = 0; chunk_row < info.chunk_rows(); ++chunk_row)
+        {
+            for (std::size_t chunk_column = 0; chunk_column < info.chunk_columns(); ++chunk_column)
+            {
+                Chunk& chunk = chunks[chunk_row * info.chunk_columns() + chunk_column];
+                chunk.offset = directory.read<std::uint64_t>();
+                chunk.size = directory.read<std::uint32_t>();
+                const auto compression = directory.read<std::uint32_t>();
+                const std::size_t raw_size = info.chunk_width(chunk_column) * info.chunk_height(chunk_row) *
+                                             info.depth * element_size(info.element);
+                if (compression > static_cast<std::uint32_t>(ChunkCompression::delta_rle) ||
+                    chunk.offset > directory_offset || chunk.size > directory_offset - chunk.offset ||
+                    (compression == static_cast<std::uint32_t>(ChunkCompression::none) && chunk.size != raw_size))
+                {
+                    throw std::runtime_error(invalid_file);
+                }
+                chunk.compression = static_cast<ChunkCompression>(compression);
+            }
+        }
+        maps_.push_back(std::move(info));
+        chunks_.push_back(std::move(chunks));
+    }
+}
+
+const std::vector<MapInfo>& MapFile::maps() const
+{
+    return maps_;
+}
+
+std::optional<std::size_t> MapFile::find(std::string_view name) const
+{
+    for (std::size_t map = 0; map < maps_.size(); ++map)
+    {
+        if (maps_[map].name == name)
+        {
+            return map;
+        }
+    }
+    return std::nullopt;
+}
+
+ChunkCompression MapFile::compression(std::size_t map, std::size_t chunk_row, std::size_t chunk_column) const
+{
+    return chunk(maps_.at(map).element, map, chunk_row, chunk_column).compression;
+}
+
+void MapFile::advise(AccessPattern pattern) const
+{
+    file_.advise(pattern);
+}
+
+const MapFile::Chunk& MapFile::chunk(MapElement element, std::size_t map, std::size_t chunk_row,
+                                     std::size_t chunk_column) const
+{
+    const MapInfo& info = maps_.at(map);
+    if (info.element != element)
+    {
+        throw std::invalid_argument("Wrong value type for map " + info.name);
+    }
+    if (chunk_row >= info.chunk_rows() || chunk_column >= info.chunk_columns())
+    {
+        throw std::out_of_range("No such chunk in map " + info.name);
+    }
+    return chunks_[map][chunk_row * info.chunk_columns() + chunk_column];
+}
+
+ImageView<std::uint8_t> MapFile::raw_chunk(MapElement element, std::size_t map, std::size_t chunk_row,
+                                           std::size_t chunk_column) const
+{
+    const Chunk& entry = chunk(element, map, chunk_row, chunk_column);
+    const MapInfo& info = maps_[map];
+    if (entry.compression != ChunkCompression::none)
+    {
+        throw std::invalid_argument("Compressed chunk in map " + info.name + " can't be viewed in place");
+    }
+    const std::size_t pixel_size = info.depth * element_size(info.element);
+    const std::size_t width = info.chunk_width(chunk_column);
+    return ImageView<std::uint8_t>{reinterpret_cast<const std::uint8_t*>(file_.data() + entry.offset), width,
+                                   info.chunk_height(chunk_row), pixel_size, width * pixel_size};
+}
+
+void MapFile::read_chunk(MapElement element, std::size_t map, std::size_t chunk_row, std::size_t chunk_column,
+                         MutableImageView<std::uint8_t> destination) const
+{
+    const Chunk& entry = chunk(element, map, chunk_row, chunk_column);
+    const MapInfo& info = maps_[map];
+    assert(destination.width() == info.chunk_width(chunk_column) &&
+           destination.height() == info.chunk_height(chunk_row) &&
+           destination.depth() == info.depth * element_size(info.element));
+
+    const auto* data = reinterpret_cast<const std::uint8_t*>(file_.data() + entry.offset);
+    if (entry.compression == ChunkCompression::delta_rle)
+    {
+        decode_chunk(data, entry.size, info.element, info.depth, destination);
+        return;
+    }
+    const std::size_t row_size = destination.width() * destination.depth();
+    for (std::size_t i = 0; i < destination.height(); ++i)
+    {
+        std::memcpy(destination.row(i), data + i * row_size, row_size);
+    }
+}
\ No newline at end of file
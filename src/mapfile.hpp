@@ -0,0 +1,188 @@
+#ifndef MAP_FILE_HPP
+#define MAP_FILE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "image.hpp"
+#include "imageview.hpp"
+#include "mappedfile.hpp"
+
+// Type of the values of a map stored in a map file
+enum class MapElement : std::uint8_t
+{
+    uint8,
+    uint16,
+    float32
+};
+
+template<typename T>
+constexpr MapElement map_element()
+{
+    if constexpr (std::is_same_v<T, std::uint8_t>)
+    {
+        return MapElement::uint8;
+    }
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+    {
+        return MapElement::uint16;
+    }
+    else
+    {
+        static_assert(std::is_same_v<T, float>, "Map files store uint8, uint16 or float values");
+        return MapElement::float32;
+    }
+}
+
+/*
+Encoding of a chunk: raw values, or each value minus its left neighbour
+(the value above for the first column), split in byte planes that are
+run-length encoded. Smooth maps have small differences, so the high
+byte planes collapse into long runs. Chunks that don't shrink are
+stored raw.
+*/
+enum class ChunkCompression : std::uint8_t
+{
+    none,
+    delta_rle
+};
+
+/*
+Description of a map in a map file. The map is split in square chunks of
+chunk_size x chunk_size pixels (clipped at the right and bottom borders),
+laid out row by row.
+*/
+struct MapInfo
+{
+    std::string name;
+    MapElement element{MapElement::float32};
+    std::size_t width{0};
+    std::size_t height{0};
+    std::size_t depth{1};
+    std::size_t chunk_size{0};
+
+    std::size_t chunk_rows() const
+    {
+        return (height + chunk_size - 1) / chunk_size;
+    }
+
+    std::size_t chunk_columns() const
+    {
+        return (width + chunk_size - 1) / chunk_size;
+    }
+
+    std::size_t chunk_height(std::size_t chunk_row) const
+    {
+        return std::min(chunk_size, height - chunk_row * chunk_size);
+    }
+
+    std::size_t chunk_width(std::size_t chunk_column) const
+    {
+        return std::min(chunk_size, width - chunk_column * chunk_size);
+    }
+};
+
+/*
+Writer of map files, the native container of height, normal and
+auxiliary maps. A file holds any number of named maps; each map is
+stored as independent chunks, so any chunk can be read without decoding
+the others. Chunks start on 64-byte boundaries, and the directory of maps
+and chunk offsets follows the chunks. The file can't be opened until
+finish writes the directory.
+*/
+class MapFileWriter
+{
+public:
+    explicit MapFileWriter(const std::filesystem::path& path);
+    MapFileWriter(const MapFileWriter&) = delete;
+    MapFileWriter& operator=(const MapFileWriter&) = delete;
+    ~MapFileWriter() = default;
+
+    template<typename T>
+    void add_map(std::string_view name, ImageView<T> map, std::size_t chunk_size = 256,
+                 ChunkCompression compression = ChunkCompression::none);
+
+    void finish();
+
+private:
+    struct Chunk
+    {
+        std::uint64_t offset{0};
+        std::uint32_t size{0};
+        ChunkCompression compression{ChunkCompression::none};
+    };
+
+    std::filesystem::path path_;
+    std::ofstream file_;
+    std::uint64_t offset_{0};
+    std::vector<MapInfo> maps_;
+    std::vector<std::vector<Chunk>> chunks_;
+    std::vector<std::uint8_t> chunk_buffer_;
+    std::vector<std::uint8_t> encoded_buffer_;
+
+    // The map as bytes: every pixel holds depth * sizeof(value) bytes
+    void add_map(MapInfo info, ImageView<std::uint8_t> bytes, ChunkCompression compression);
+    void write(const void* data, std::size_t size);
+};
+
+/*
+Read-only, memory-mapped map file. Opening parses just the directory, so
+it takes microseconds whatever the size of the maps; chunks are paged in
+when read. Uncompressed chunks can be used in place through views of the
+mapping (chunk_view), the other ones are decoded by read_chunk. Views are
+valid while the MapFile exists.
+*/
+class MapFile
+{
+public:
+    explicit MapFile(const std::filesystem::path& path);
+
+    const std::vector<MapInfo>& maps() const;
+    std::optional<std::size_t> find(std::string_view name) const;
+    ChunkCompression compression(std::size_t map, std::size_t chunk_row, std::size_t chunk_column) const;
+
+    // Zero-copy view of an uncompressed chunk; throws for compressed chunks and for the wrong value type
+    template<typename T>
+    ImageView<T> chunk_view(std::size_t map, std::size_t chunk_row, std::size_t chunk_column) const;
+
+    // Copy or decode a chunk into destination, which has the size of the chunk
+    template<typename T>
+    void read_chunk(std::size_t map, std::size_t chunk_row, std::size_t chunk_column,
+                    MutableImageView<T> destination) const;
+
+    // Whole map, with its chunk rows split across workers
+    template<typename T>
+    Image<T> read_map(std::size_t map, std::size_t workers = 1) const;
+
+    void advise(AccessPattern pattern) const;
+
+private:
+    struct Chunk
+    {
+        std::uint64_t offset{0};
+        std::uint32_t size{0};
+        ChunkCompression compression{ChunkCompression::none};
+    };
+
+    MappedFile file_;
+    std::vector<MapInfo> maps_;
+    std::vector<std::vector<Chunk>> chunks_;
+
+    const Chunk& chunk(MapElement element, std::size_t map, std::size_t chunk_row, std::size_t chunk_column) const;
+    ImageView<std::uint8_t> raw_chunk(MapElement element, std::size_t map, std::size_t chunk_row,
+                                      std::size_t chunk_column) const;
+    void read_chunk(MapElement element, std::size_t map, std::size_t chunk_row, std::size_t chunk_column,
+                    MutableImageView<std::uint8_t> destination) const;
+};
+
+#include "mapfile.inl"
+
+#endif // MAP_FILE_HPP
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "mapfile.hpp"
+
+#include "parallel.hpp"
+
+template<typename T>
+void MapFileWriter::add_map(std::string_view name, ImageView<T> map, std::size_t chunk_size,
+                            ChunkCompression compression)
+{
+    const ImageView<std::uint8_t> bytes{reinterpret_cast<const std::uint8_t*>(map.data()), map.width(), map.height(),
+                                        map.depth() * sizeof(T), map.pitch() * sizeof(T)};
+    add_map(MapInfo{std::string{name}, map_element<T>(), map.width(), map.height(), map.depth(), chunk_size}, bytes,
+            compression);
+}
+
+template<typename T>
+ImageView<T> MapFile::chunk_view(std::size_t map, std::size_t chunk_row, std::size_t chunk_column) const
+{
+    const ImageView<std::uint8_t> bytes = raw_chunk(map_element<T>(), map, chunk_row, chunk_column);
+    return ImageView<T>{reinterpret_cast<const T*>(bytes.data()), bytes.width(), bytes.height(), maps_[map].depth,
+                        bytes.pitch() / sizeof(T)};
+}
+
+template<typename T>
+void MapFile::read_chunk(std::size_t map, std::size_t chunk_row, std::size_t chunk_column,
+                         MutableImageView<T> destination) const
+{
+    const MutableImageView<std::uint8_t> bytes{reinterpret_cast<std::uint8_t*>(destination.data()),
+                                               destination.width(), destination.height(),
+                                               destination.depth() * sizeof(T), destination.pitch() * sizeof(T)};
+    read_chunk(map_element<T>(), map, chunk_row, chunk_column, bytes);
+}
+
+template<typename T>
+Image<T> MapFile::read_map(std::size_t map, std::size_t workers) const
+{
+    const MapInfo& info = maps_.at(map);
+    Image<T> image{info.width, info.height, info.depth};
+    const MutableImageView<T> view = image.mutable_view();
+    parallel_for_bands(info.chunk_rows(), workers, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t chunk_row = first_row; chunk_row < last_row; ++chunk_row)
+        {
+            for (std::size_t chunk_column = 0; chunk_column < info.chunk_columns(); ++chunk_column)
+            {
+                read_chunk(map, chunk_row, chunk_column,
+                           view.subview(chunk_row * info.chunk_size, chunk_column * info.chunk_size,
+                                        info.chunk_height(chunk_row), info.chunk_width(chunk_column)));
+            }
+        }
+    });
+    return image;
+}
\ No newline at end of file
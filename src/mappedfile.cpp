@@ -0,0 +1,306 @@
+#include "mappedfile.hpp"
+
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef _WIN32
+
+[[noreturn]] void throw_last_error(const std::string& message)
+{
+    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), message);
+}
+
+std::byte* map_file(const std::filesystem::path& path, std::size_t size)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw_last_error("Failure to open " + path.string());
+    }
+
+    LARGE_INTEGER file_size{};
+    file_size.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, file_size, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+    {
+        const DWORD error = GetLastError();
+        CloseHandle(file);
+        SetLastError(error);
+        throw_last_error("Failure to resize " + path.string());
+    }
+    if (size == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // The view keeps the file and the mapping objects alive after their handles are closed
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    const DWORD mapping_error = GetLastError();
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        SetLastError(mapping_error);
+        throw_last_error("Failure to map " + path.string());
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    const DWORD view_error = GetLastError();
+    CloseHandle(mapping);
+    if (view == nullptr)
+    {
+        SetLastError(view_error);
+        throw_last_error("Failure to map " + path.string());
+    }
+    return static_cast<std::byte*>(view);
+}
+
+std::byte* map_existing_file(const std::filesystem::path& path, std::size_t& size)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw_last_error("Failure to open " + path.string());
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        const DWORD error = GetLastError();
+        CloseHandle(file);
+        SetLastError(error);
+        throw_last_error("Failure to read the size of " + path.string());
+    }
+    size = static_cast<std::size_t>(file_size.QuadPart);
+    if (size == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const DWORD mapping_error = GetLastError();
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        SetLastError(mapping_error);
+        throw_last_error("Failure to map " + path.string());
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    const DWORD view_error = GetLastError();
+    CloseHandle(mapping);
+    if (view == nullptr)
+    {
+        SetLastError(view_error);
+        throw_last_error("Failure to map " + path.string());
+    }
+    return static_cast<std::byte*>(view);
+}
+
+#else
+
+[[noreturn]] void throw_errno(const std::string& message)
+{
+    throw std::system_error(errno, std::generic_category(), message);
+}
+
+std::byte* map_file(const std::filesystem::path& path, std::size_t size)
+{
+    const int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file == -1)
+    {
+        throw_errno("Failure to open " + path.string());
+    }
+    if (ftruncate(file, static_cast<off_t>(size)) == -1)
+    {
+        const int error = errno;
+        close(file);
+        errno = error;
+        throw_errno("Failure to resize " + path.string());
+    }
+    if (size == 0)
+    {
+        close(file);
+        return nullptr;
+    }
+
+    // The mapping keeps the file open after its descriptor is closed
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    const int error = errno;
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        errno = error;
+        throw_errno("Failure to map " + path.string());
+    }
+    return static_cast<std::byte*>(mapping);
+}
+
+std::byte* map_existing_file(const std::filesystem::path& path, std::size_t& size)
+{
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        throw_errno("Failure to open " + path.string());
+    }
+    struct stat status{};
+    if (fstat(file, &status) == -1)
+    {
+        const int error = errno;
+        close(file);
+        errno = error;
+        throw_errno("Failure to read the size of " + path.string());
+    }
+    size = static_cast<std::size_t>(status.st_size);
+    if (size == 0)
+    {
+        close(file);
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    const int error = errno;
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        errno = error;
+        throw_errno("Failure to map " + path.string());
+    }
+    return static_cast<std::byte*>(mapping);
+}
+
+#endif
+
+} // namespace
+
+MappedFile::MappedFile(const std::filesystem::path& path, std::size_t size) :
+    path_{path}, data_{map_file(path, size)}, size_{size}, writable_{true}
+{
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path) : path_{path}
+{
+    data_ = map_existing_file(path, size_);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    path_{std::move(other.path_)}, data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)},
+    writable_{other.writable_}
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        path_ = std::move(other.path_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        writable_ = other.writable_;
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+void MappedFile::unmap()
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::advise(AccessPattern pattern) const
+{
+#ifdef _WIN32
+    (void)pattern;
+#else
+    if (data_ == nullptr)
+    {
+        return;
+    }
+    int advice{MADV_NORMAL};
+    switch (pattern)
+    {
+    case AccessPattern::normal:
+        advice = MADV_NORMAL;
+        break;
+    case AccessPattern::sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case AccessPattern::random:
+        advice = MADV_RANDOM;
+        break;
+    }
+    // Only a hint: a failure leaves the default behaviour in place
+    madvise(data_, size_, advice);
+#endif
+}
+
+void MappedFile::flush() const
+{
+    if (data_ == nullptr || !writable_)
+    {
+        return;
+    }
+#ifdef _WIN32
+    if (!FlushViewOfFile(data_, 0))
+    {
+        throw_last_error("Failure to write " + path_.string());
+    }
+#else
+    if (msync(data_, size_, MS_SYNC) == -1)
+    {
+        throw_errno("Failure to write " + path_.string());
+    }
+#endif
+}
+
+std::byte* MappedFile::data() const
+{
+    return data_;
+}
+
+std::size_t MappedFile::size() const
+{
+    return size_;
+}
+
+bool MappedFile::writable() const
+{
+    return writable_;
+}
+
+const std::filesystem::path& MappedFile::path() const
+{
+    return path_;
+}
\ No newline at end of file
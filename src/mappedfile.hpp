@@ -0,0 +1,61 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+
+// Expected order of the accesses to a mapping, used to tune read-ahead and page eviction
+enum class AccessPattern
+{
+    normal,
+    sequential,
+    random
+};
+
+/*
+Read-write memory mapping of a whole file. The file is created if it
+doesn't exist and resized to the requested size; existing contents are
+kept and new bytes are zero. Writes go to the page cache and are written
+back to the file by the OS, so a mapping can be much larger than the
+physical memory: untouched pages are read on demand and clean or written
+back pages are evicted under memory pressure. Mappings start page
+aligned. Existing files can also be mapped read-only, whatever their
+size; writing to a read-only mapping is an access violation.
+*/
+class MappedFile
+{
+public:
+    MappedFile(const std::filesystem::path& path, std::size_t size);
+    // Read-only mapping of the whole of an existing file
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    /*
+    Hint about upcoming accesses (madvise on POSIX systems, ignored
+    elsewhere). Sequential access reads ahead aggressively and lets the
+    pages behind be dropped early; random access disables read-ahead.
+    */
+    void advise(AccessPattern pattern) const;
+
+    // Start writing the modified pages back to the file (and wait for completion on POSIX systems)
+    void flush() const;
+
+    std::byte* data() const;
+    std::size_t size() const;
+    bool writable() const;
+    const std::filesystem::path& path() const;
+
+private:
+    std::filesystem::path path_;
+    std::byte* data_{nullptr};
+    std::size_t size_{0};
+    bool writable_{false};
+
+    void unmap();
+};
+
+#endif // MAPPED_FILE_HPP
\ No newline at end of file
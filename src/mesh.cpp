@@ -30,6 +30,12 @@ Mesh::Mesh(std::vector<float> vertices_data, std::vector<int> attributes_sizes)
     }
 }
 
+Mesh::Mesh(int number_of_vertices) : number_of_vertices_{number_of_vertices}
+{
+    // Core profiles still need a vertex array to draw, even without attributes
+    glGenVertexArrays(1, &vertex_array_identifier_);
+}
+
 Mesh::Mesh(Mesh&& other) noexcept :
     number_of_vertices_{other.number_of_vertices_}, vertex_array_identifier_{other.vertex_array_identifier_}
 {
@@ -76,6 +82,12 @@ PatchMesh::PatchMesh(int vertices_per_patch, std::vector<float> vertices_data) :
     glPatchParameteri(GL_PATCH_VERTICES, vertices_per_patch_);
 }
 
+PatchMesh::PatchMesh(int vertices_per_patch, int number_of_vertices) :
+    Mesh{number_of_vertices}, vertices_per_patch_{vertices_per_patch}
+{
+    glPatchParameteri(GL_PATCH_VERTICES, vertices_per_patch_);
+}
+
 void PatchMesh::render()
 {
     bind();
@@ -97,16 +109,50 @@ IndexedMesh::IndexedMesh(std::vector<float> vertices_data, std::vector<std::uint
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    set_vertex_format();
+}
+
+IndexedMesh::IndexedMesh(std::vector<std::uint16_t> vertices_data, std::vector<std::uint32_t> indices) :
+    number_of_vertices_{static_cast<int>(vertices_data.size())}, number_of_indices_{static_cast<int>(indices.size())},
+    vertex_stride_{sizeof(std::uint16_t)}
+{
+    glCreateVertexArrays(1, &vertex_array_identifier_);
+    glBindVertexArray(vertex_array_identifier_);
+
+    glGenBuffers(1, &vertex_buffer_identifier_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
+    glBufferData(GL_ARRAY_BUFFER, vertices_data.size() * sizeof(std::uint16_t), vertices_data.data(),
+                 GL_STATIC_DRAW);
+
+    glGenBuffers(1, &element_buffer_object_id_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(std::uint16_t), 0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+}
+
+IndexedMesh::IndexedMesh(std::size_t number_of_vertices, std::size_t number_of_indices) :
+    number_of_vertices_{static_cast<int>(number_of_vertices)}, number_of_indices_{static_cast<int>(number_of_indices)}
+{
+    glCreateVertexArrays(1, &vertex_array_identifier_);
+    glBindVertexArray(vertex_array_identifier_);
+
+    glGenBuffers(1, &vertex_buffer_identifier_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
+    glBufferData(GL_ARRAY_BUFFER, number_of_vertices * vertex_stride_, nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &element_buffer_object_id_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, number_of_indices * sizeof(std::uint32_t), nullptr, GL_STATIC_DRAW);
+
+    set_vertex_format();
 }
 
 IndexedMesh::IndexedMesh(IndexedMesh&& mesh) noexcept :
     number_of_vertices_{mesh.number_of_vertices_}, number_of_indices_{mesh.number_of_indices_},
-    vertex_array_identifier_{mesh.vertex_array_identifier_}, vertex_buffer_identifier_{mesh.vertex_buffer_identifier_},
-    element_buffer_object_id_{mesh.element_buffer_object_id_}
+    vertex_stride_{mesh.vertex_stride_}, vertex_array_identifier_{mesh.vertex_array_identifier_},
+    vertex_buffer_identifier_{mesh.vertex_buffer_identifier_}, element_buffer_object_id_{mesh.element_buffer_object_id_}
 {
     mesh.number_of_vertices_ = 0;
     mesh.number_of_indices_ = 0;
@@ -119,6 +165,7 @@ IndexedMesh& IndexedMesh::operator=(IndexedMesh&& mesh) noexcept
 {
     std::swap(number_of_vertices_, mesh.number_of_vertices_);
     std::swap(number_of_indices_, mesh.number_of_indices_);
+    std::swap(vertex_stride_, mesh.vertex_stride_);
     std::swap(vertex_array_identifier_, mesh.vertex_array_identifier_);
     std::swap(vertex_buffer_identifier_, mesh.vertex_buffer_identifier_);
     std::swap(element_buffer_object_id_, mesh.element_buffer_object_id_);
@@ -143,8 +190,58 @@ void IndexedMesh::render()
     glDrawElements(GL_TRIANGLES, number_of_indices_, GL_UNSIGNED_INT, 0);
 }
 
+std::pair<std::span<float>, std::span<std::uint32_t>> IndexedMesh::map_buffers()
+{
+    if (vertex_stride_ % sizeof(float) != 0)
+    {
+        return {};
+    }
+
+    const auto vertex_values = static_cast<std::size_t>(number_of_vertices_) * vertex_stride_ / sizeof(float);
+    const auto index_count = static_cast<std::size_t>(number_of_indices_);
+    constexpr GLbitfield access{GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT};
+
+    // The element buffer binding is part of the vertex array
+    bind();
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
+    auto* vertices = static_cast<float*>(
+        glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertex_values * sizeof(float)), access));
+    auto* indices = static_cast<std::uint32_t*>(glMapBufferRange(
+        GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(index_count * sizeof(std::uint32_t)), access));
+    if (vertices == nullptr || indices == nullptr)
+    {
+        if (vertices != nullptr)
+        {
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        if (indices != nullptr)
+        {
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        }
+        return {};
+    }
+    return {std::span<float>{vertices, vertex_values}, std::span<std::uint32_t>{indices, index_count}};
+}
+
+bool IndexedMesh::unmap_buffers()
+{
+    bind();
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
+    const bool vertices_intact = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+    const bool indices_intact = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE;
+    return vertices_intact && indices_intact;
+}
+
 void IndexedMesh::update_mesh(std::vector<float> vertices_data, std::vector<std::uint32_t> indices)
 {
     glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_data.size() * sizeof(float), vertices_data.data());
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(std::uint32_t), indices.data());
+}
+
+void IndexedMesh::set_vertex_format()
+{
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
 }
\ No newline at end of file
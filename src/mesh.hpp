@@ -1,7 +1,10 @@
 #ifndef MESH_HPP
 #define MESH_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <utility>
 #include <vector>
 
 class Mesh
@@ -9,6 +12,8 @@ class Mesh
 public:
     // Default vertex attributes: position (3) + texture coordinates (2)
     explicit Mesh(std::vector<float> vertices_data, std::vector<int> attributes_sizes = {3, 2});
+    // Mesh without vertex data, whose vertex shader derives the vertices from gl_VertexID
+    explicit Mesh(int number_of_vertices);
     Mesh(const Mesh&) = delete;
     Mesh(Mesh&& other) noexcept;
     Mesh& operator=(const Mesh&) = delete;
@@ -31,6 +36,7 @@ class PatchMesh: public Mesh
 {
 public:
     PatchMesh(int vertices_per_patch, std::vector<float> vertices_data);
+    PatchMesh(int vertices_per_patch, int number_of_vertices);
 
     PatchMesh(const PatchMesh&) = delete;
     PatchMesh(PatchMesh&&) = default;
@@ -47,6 +53,10 @@ class IndexedMesh
 {
 public:
     IndexedMesh(std::vector<float> vertices_data, std::vector<std::uint32_t> indices);
+    // Compact vertices of a single 16-bit unsigned normalized attribute (e.g. heights, see compact_grid_mesh)
+    IndexedMesh(std::vector<std::uint16_t> vertices_data, std::vector<std::uint32_t> indices);
+    // Uninitialized buffers of the given sizes, to be filled through map_buffers
+    IndexedMesh(std::size_t number_of_vertices, std::size_t number_of_indices);
     
     IndexedMesh(const IndexedMesh&) = delete;
     IndexedMesh(IndexedMesh&& mesh) noexcept;
@@ -57,9 +67,27 @@ public:
     void bind();
     void render();
     void update_mesh(std::vector<float> vertices_data, std::vector<std::uint32_t> indices);
+
+    /*
+    Map the vertex and index buffers for writing, discarding their
+    contents, so they can be filled in place (e.g. by build_grid_mesh)
+    without a copy in client memory. The vertex span covers the whole
+    vertex buffer, whatever the number of floats per vertex. The spans
+    are empty if the driver can't map the buffers or if the vertices
+    aren't made of floats (compact meshes). unmap_buffers must be called
+    before rendering; it returns false if the contents were lost and must
+    be written again.
+    */
+    std::pair<std::span<float>, std::span<std::uint32_t>> map_buffers();
+    bool unmap_buffers();
 private:
+    void set_vertex_format();
+
+
     int number_of_vertices_{0};
     int number_of_indices_{0};
+    // Bytes per vertex: position (3) + texture coordinates (2) floats, or a single 16-bit value
+    std::size_t vertex_stride_{5 * sizeof(float)};
     std::uint32_t vertex_array_identifier_{0};
     std::uint32_t vertex_buffer_identifier_{0};
     std::uint32_t element_buffer_object_id_{0};
@@ -1,21 +1,36 @@
 #ifndef MESH_GENERATION_HPP
 #define MESH_GENERATION_HPP
 
+#include <cstddef>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "gridmesh.hpp"
 #include "image.hpp"
 
-class CubicHermiteCurve;
 class IndexedMesh;
 class Mesh;
 class PatchMesh;
 
-std::pair<std::vector<float>, std::vector<std::uint32_t>> grid_mesh(int width, int height, const Image<float>& height_map, const CubicHermiteCurve& curve);
+// The vertices are computed by workers threads (0 for one worker per hardware thread)
+std::unique_ptr<IndexedMesh> create_indexed_grid_mesh(int width, int height, const Image<float>& height_map,
+                                                      const CubicHermiteCurve& curve, std::size_t workers = 1);
 
-std::unique_ptr<IndexedMesh> create_indexed_grid_mesh(int width, int height, const Image<float>& height_map, const CubicHermiteCurve& curve);
+// Mesh of 16-bit heights for vertex pulling (see compact_grid_mesh)
+std::unique_ptr<IndexedMesh> create_compact_grid_mesh(int width, int height, const Image<float>& height_map,
+                                                      const CubicHermiteCurve& curve, std::size_t workers = 1);
+
+// Grid of 2 triangles per quad without vertex data, drawn with ATTRIBUTELESS_VERTICES (see compact_grid_mesh)
+std::unique_ptr<Mesh> create_attributeless_grid_mesh(int width, int height);
 
 std::unique_ptr<PatchMesh> create_grid_patch(int width, int height, int number_of_patches);
 
+/*
+Patches of create_grid_patch without vertex data: the vertex shader derives
+the corners of patch gl_VertexID / 4 from the grid size and the number of
+patches (VERTEX_PULLING in assets/shaders/gpu_terrain/vertex_shader.vs).
+*/
+std::unique_ptr<PatchMesh> create_attributeless_grid_patch(int number_of_patches);
+
 #endif // MESH_GENERATION_HPP
\ No newline at end of file
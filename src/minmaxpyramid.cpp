@@ -0,0 +1,247 @@
+#include "minmaxpyramid.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "parallel.hpp"
+#include "simd.hpp"
+
+namespace
+{
+
+using Batch = simd::NativeFloatBatch;
+using simd::max;
+using simd::min;
+
+// Cells of a level with the given cell size along a side of texels texels (the last one may be partial)
+std::size_t cell_count(std::size_t texels, std::size_t cell_size)
+{
+    return std::max<std::size_t>(1, (texels - 1 + cell_size - 1) / cell_size);
+}
+
+// Smallest and largest values of the rows [first_row, last_row] for each of count columns
+void reduce_rows(ImageView<float> height_map, std::size_t first_row, std::size_t last_row, std::size_t first_column,
+                 std::size_t count, float* row_min, float* row_max)
+{
+    const float* first = height_map.row(first_row) + first_column;
+    std::copy(first, first + count, row_min);
+    std::copy(first, first + count, row_max);
+    for (std::size_t i = first_row + 1; i <= last_row; ++i)
+    {
+        const float* values = height_map.row(i) + first_column;
+        std::size_t j{0};
+        for (; j + Batch::lanes <= count; j += Batch::lanes)
+        {
+            const Batch batch = Batch::load(values + j);
+            min(Batch::load(row_min + j), batch).store(row_min + j);
+            max(Batch::load(row_max + j), batch).store(row_max + j);
+        }
+        for (; j < count; ++j)
+        {
+            row_min[j] = min(row_min[j], values[j]);
+            row_max[j] = max(row_max[j], values[j]);
+        }
+    }
+}
+
+} // namespace
+
+MinMaxPyramid::MinMaxPyramid(ImageView<float> height_map, std::size_t workers) :
+    width_{height_map.width()}, height_{height_map.height()}
+{
+    assert(width_ > 0 && height_ > 0);
+    for (std::size_t size = 2;; size *= 2)
+    {
+        const std::size_t rows = cell_count(height_, size);
+        const std::size_t columns = cell_count(width_, size);
+        levels_.emplace_back(columns, rows, 2);
+        if (rows == 1 && columns == 1)
+        {
+            break;
+        }
+    }
+
+    /*
+    The parents of a band of cell rows only depend on the band, so the
+    bands of rows of the split level build every level up to it
+    independently; the few levels above are built afterwards.
+    */
+    const std::size_t bands = band_count(levels_[0].height(), workers);
+    std::size_t split = 0;
+    while (split + 1 < levels_.size() && levels_[split + 1].height() >= 4 * bands)
+    {
+        ++split;
+    }
+    parallel_for_bands(levels_[split].height(), workers, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        std::vector<float> row_min;
+        std::vector<float> row_max;
+        for (std::size_t level = 0; level <= split; ++level)
+        {
+            const std::size_t shift = split - level;
+            compute_cells(height_map, level, first_row << shift,
+                          std::min(last_row << shift, levels_[level].height()), 0, levels_[level].width(), row_min,
+                          row_max);
+        }
+    });
+    std::vector<float> row_min;
+    std::vector<float> row_max;
+    for (std::size_t level = split + 1; level < levels_.size(); ++level)
+    {
+        compute_cells(height_map, level, 0, levels_[level].height(), 0, levels_[level].width(), row_min, row_max);
+    }
+}
+
+void MinMaxPyramid::update(ImageView<float> height_map, std::size_t first_row, std::size_t first_column,
+                           std::size_t rows, std::size_t columns)
+{
+    assert(height_map.width() == width_ && height_map.height() == height_);
+    assert(first_row + rows <= height_ && first_column + columns <= width_);
+    if (rows == 0 || columns == 0)
+    {
+        return;
+    }
+
+    // Level 0 cells i cover the texels [2i, 2i + 2], so the ones touching [first, last] start at ceil((first - 2) / 2)
+    const auto first_cell = [](std::size_t first) { return first <= 2 ? 0 : (first - 1) / 2; };
+    std::size_t first_cell_row = first_cell(first_row);
+    std::size_t last_cell_row = std::min((first_row + rows - 1) / 2, levels_[0].height() - 1);
+    std::size_t first_cell_column = first_cell(first_column);
+    std::size_t last_cell_column = std::min((first_column + columns - 1) / 2, levels_[0].width() - 1);
+
+    std::vector<float> row_min;
+    std::vector<float> row_max;
+    for (std::size_t level = 0; level < levels_.size(); ++level)
+    {
+        compute_cells(height_map, level, first_cell_row, last_cell_row + 1, first_cell_column, last_cell_column + 1,
+                      row_min, row_max);
+        first_cell_row /= 2;
+        last_cell_row /= 2;
+        first_cell_column /= 2;
+        last_cell_column /= 2;
+    }
+}
+
+std::pair<float, float> MinMaxPyramid::bounds(std::size_t first_row, std::size_t first_column, std::size_t rows,
+                                              std::size_t columns) const
+{
+    assert(rows > 0 && columns > 0 && first_row + rows <= height_ && first_column + columns <= width_);
+    const std::size_t last_row = first_row + rows - 1;
+    const std::size_t last_column = first_column + columns - 1;
+    // Below the levels whose cells span at least half the region, the region covers 3 cells or more per side
+    const std::size_t extent = std::max(rows, columns) - 1;
+    std::size_t level = 0;
+    while (level + 1 < levels_.size() && 2 * cell_size(level) < extent)
+    {
+        ++level;
+    }
+    for (;; ++level)
+    {
+        const ImageView<float> cells = levels_[level];
+        const std::size_t size = cell_size(level);
+        const std::size_t first_cell_row = std::min(first_row / size, cells.height() - 1);
+        const std::size_t last_cell_row = std::min(last_row / size, cells.height() - 1);
+        const std::size_t first_cell_column = std::min(first_column / size, cells.width() - 1);
+        const std::size_t last_cell_column = std::min(last_column / size, cells.width() - 1);
+        // The top level has a single cell, so the search always ends
+        if (last_cell_row - first_cell_row > 1 || last_cell_column - first_cell_column > 1)
+        {
+            continue;
+        }
+
+        std::pair<float, float> range{cells.get(first_cell_row, first_cell_column, 0),
+                                      cells.get(first_cell_row, first_cell_column, 1)};
+        for (std::size_t i = first_cell_row; i <= last_cell_row; ++i)
+        {
+            for (std::size_t j = first_cell_column; j <= last_cell_column; ++j)
+            {
+                range.first = min(range.first, cells.get(i, j, 0));
+                range.second = max(range.second, cells.get(i, j, 1));
+            }
+        }
+        return range;
+    }
+}
+
+std::size_t MinMaxPyramid::levels() const
+{
+    return levels_.size();
+}
+
+ImageView<float> MinMaxPyramid::level(std::size_t level) const
+{
+    return levels_[level].view();
+}
+
+std::size_t MinMaxPyramid::cell_size(std::size_t level) const
+{
+    return std::size_t{2} << level;
+}
+
+std::size_t MinMaxPyramid::width() const
+{
+    return width_;
+}
+
+std::size_t MinMaxPyramid::height() const
+{
+    return height_;
+}
+
+// Cells [first_row, last_row) x [first_column, last_column) of a level, from the height map or the level below
+void MinMaxPyramid::compute_cells(ImageView<float> height_map, std::size_t level, std::size_t first_row,
+                                  std::size_t last_row, std::size_t first_column, std::size_t last_column,
+                                  std::vector<float>& row_min, std::vector<float>& row_max)
+{
+    Image<float>& cells = levels_[level];
+    if (level > 0)
+    {
+        const Image<float>& children = levels_[level - 1];
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            const std::size_t last_child_row = std::min(2 * i + 1, children.height() - 1);
+            for (std::size_t j = first_column; j < last_column; ++j)
+            {
+                const std::size_t last_child_column = std::min(2 * j + 1, children.width() - 1);
+                float cell_min = children.get(2 * i, 2 * j, 0);
+                float cell_max = children.get(2 * i, 2 * j, 1);
+                for (std::size_t child_row = 2 * i; child_row <= last_child_row; ++child_row)
+                {
+                    for (std::size_t child_column = 2 * j; child_column <= last_child_column; ++child_column)
+                    {
+                        cell_min = min(cell_min, children.get(child_row, child_column, 0));
+                        cell_max = max(cell_max, children.get(child_row, child_column, 1));
+                    }
+                }
+                cells.set(i, j, 0, cell_min);
+                cells.set(i, j, 1, cell_max);
+            }
+        }
+        return;
+    }
+
+    // Reduce the 3 texel rows of a cell row with vector loads first, then the 3 columns of each cell
+    const std::size_t first_texel_column = 2 * first_column;
+    const std::size_t texel_columns = std::min(2 * last_column + 1, width_) - first_texel_column;
+    row_min.resize(texel_columns);
+    row_max.resize(texel_columns);
+    for (std::size_t i = first_row; i < last_row; ++i)
+    {
+        reduce_rows(height_map, 2 * i, std::min(2 * i + 2, height_ - 1), first_texel_column, texel_columns,
+                    row_min.data(), row_max.data());
+        float* cell = cells.row(i);
+        for (std::size_t j = first_column; j < last_column; ++j)
+        {
+            const std::size_t first_texel = 2 * j - first_texel_column;
+            const std::size_t last_texel = std::min(first_texel + 2, texel_columns - 1);
+            float cell_min = row_min[first_texel];
+            float cell_max = row_max[first_texel];
+            for (std::size_t texel = first_texel + 1; texel <= last_texel; ++texel)
+            {
+                cell_min = min(cell_min, row_min[texel]);
+                cell_max = max(cell_max, row_max[texel]);
+            }
+            cell[2 * j] = cell_min;
+            cell[2 * j + 1] = cell_max;
+        }
+    }
+}
\ No newline at end of file
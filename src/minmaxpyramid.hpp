@@ -0,0 +1,64 @@
+#ifndef MIN_MAX_PYRAMID_HPP
+#define MIN_MAX_PYRAMID_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "image.hpp"
+#include "imageview.hpp"
+
+/*
+Pyramid of the smallest and largest heights of a height map, for
+conservative bounds of any region (culling, ray casting, level of detail
+selection, collision broad phase) without scanning the map.
+
+A cell of level l covers cell_size(l) = 2^(l + 1) texel intervals per
+side: the cell (i, j) bounds the texels in rows [i * s, (i + 1) * s] and
+columns [j * s, (j + 1) * s] (clipped to the map), borders included, so
+it bounds the whole surface interpolated over its footprint. Each level
+halves the number of cells of the previous one, down to a single cell.
+Levels are stored as two-channel images of (min, max).
+*/
+class MinMaxPyramid
+{
+public:
+    MinMaxPyramid() = default;
+    // Build the whole pyramid in one bottom-up pass, splitting the cell rows across workers
+    explicit MinMaxPyramid(ImageView<float> height_map, std::size_t workers = 1);
+
+    /*
+    Recompute the cells covering the texels [first_row, first_row + rows)
+    x [first_column, first_column + columns) after they changed. The
+    height map must have the size the pyramid was built with.
+    */
+    void update(ImageView<float> height_map, std::size_t first_row, std::size_t first_column, std::size_t rows,
+                std::size_t columns);
+
+    /*
+    Bounds (min, max) of the heights of the texels [first_row, first_row +
+    rows) x [first_column, first_column + columns), in O(log n): they come
+    from the at most 2 x 2 cells of the finest level covering the region,
+    so they can be looser than the exact range but never tighter.
+    */
+    std::pair<float, float> bounds(std::size_t first_row, std::size_t first_column, std::size_t rows,
+                                   std::size_t columns) const;
+
+    std::size_t levels() const;
+    ImageView<float> level(std::size_t level) const;
+    std::size_t cell_size(std::size_t level) const;
+
+    std::size_t width() const;
+    std::size_t height() const;
+
+private:
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::vector<Image<float>> levels_;
+
+    void compute_cells(ImageView<float> height_map, std::size_t level, std::size_t first_row, std::size_t last_row,
+                       std::size_t first_column, std::size_t last_column, std::vector<float>& row_min,
+                       std::vector<float>& row_max);
+};
+
+#endif // MIN_MAX_PYRAMID_HPP
\ No newline at end of file
@@ -3,123 +3,612 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <limits>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
-#include <glm/gtc/noise.hpp>
-#include <glm/gtc/random.hpp>
-#include <glm/gtc/type_ptr.hpp>
+
+#include "gradientnoise.hpp"
+#include "noisegraph.hpp"
+#include "parallel.hpp"
+#include "terraincache.hpp"
+
+namespace
+{
+
+// Normalizes a raw fBm sum to [0, 1], then applies the exponent and the optional Hermite curve
+struct HeightRedistribution
+{
+    float min_height;
+    float range;
+    float exponent;
+    const CubicHermiteCurve* curve;
+
+    float operator()(float raw_height) const
+    {
+        float noise_height = (raw_height - min_height) / range;
+        if (exponent != 1.0f)
+        {
+            noise_height = std::pow(noise_height, exponent);
+        }
+        if (curve != nullptr)
+        {
+            noise_height = curve->evaluate(noise_height).y;
+        }
+        return noise_height;
+    }
+};
+
+/*
+Cache-blocked Sobel pass. The map is processed in square tiles; the
+transformed heights of a tile plus a 1-texel apron are gathered into a
+small buffer that stays in L1/L2 while the tile's heights (if requested)
+and normals are written out. Only tiles touching the image border go
+through the clamped gather, so the stencil loop itself never clamps.
+Normals are stored as RGBA, or octahedral-encoded in RG when the normal
+image has 2 channels. Rows are addressed through their pitch, so the
+source can be a view of a padded image or of a rectangle of a larger one.
+*/
+template<typename Transform>
+void normal_map_pass(ImageView<float> source, Image<float>* heights, Image<std::uint8_t>& normals,
+                     std::size_t workers, Transform&& transform)
+{
+    constexpr std::size_t tile_size{64};
+    constexpr std::size_t stride{tile_size + 2};
+    const std::size_t width{source.width()};
+    const std::size_t height{source.height()};
+    const std::size_t tile_rows{(height + tile_size - 1) / tile_size};
+    const std::size_t tile_columns{(width + tile_size - 1) / tile_size};
+    const std::size_t channels{normals.depth()};
+    const float dz{1.0f / 2.0f};
+
+    parallel_for_bands(tile_rows, workers, [&](std::size_t, std::size_t first_tile_row, std::size_t last_tile_row) {
+        std::vector<float> neighborhood(stride * stride);
+        for (std::size_t tile_row = first_tile_row; tile_row < last_tile_row; ++tile_row)
+        {
+            for (std::size_t tile_column = 0; tile_column < tile_columns; ++tile_column)
+            {
+                const std::size_t first_row{tile_row * tile_size};
+                const std::size_t first_column{tile_column * tile_size};
+                const std::size_t rows{std::min(tile_size, height - first_row)};
+                const std::size_t columns{std::min(tile_size, width - first_column)};
+                const bool interior{first_row > 0 && first_column > 0 && first_row + rows < height &&
+                                    first_column + columns < width};
+
+                // Gather the tile and its apron; neighborhood(r, c) holds texel
+                // (first_row + r - 1, first_column + c - 1)
+                for (std::size_t r = 0; r < rows + 2; ++r)
+                {
+                    float* local_row = neighborhood.data() + r * stride;
+                    if (interior)
+                    {
+                        const float* source_row = source.row(first_row + r - 1) + first_column - 1;
+                        std::transform(source_row, source_row + columns + 2, local_row, transform);
+                    }
+                    else
+                    {
+                        const auto source_i = static_cast<std::size_t>(
+                            std::clamp<std::ptrdiff_t>(first_row + r - 1, 0, static_cast<std::ptrdiff_t>(height - 1)));
+                        for (std::size_t c = 0; c < columns + 2; ++c)
+                        {
+                            const auto source_j = static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(
+                                first_column + c - 1, 0, static_cast<std::ptrdiff_t>(width - 1)));
+                            local_row[c] = transform(source.row(source_i)[source_j]);
+                        }
+                    }
+                }
+
+                for (std::size_t r = 0; r < rows; ++r)
+                {
+                    const float* top_row = neighborhood.data() + r * stride;
+                    const float* center_row = top_row + stride;
+                    const float* bottom_row = center_row + stride;
+                    if (heights != nullptr)
+                    {
+                        std::copy(center_row + 1, center_row + 1 + columns,
+                                  heights->row(first_row + r) + first_column);
+                    }
+
+                    std::uint8_t* normal = normals.row(first_row + r) + first_column * channels;
+                    for (std::size_t c = 0; c < columns; ++c, normal += channels)
+                    {
+                        const float top_left = top_row[c];
+                        const float top = top_row[c + 1];
+                        const float top_right = top_row[c + 2];
+                        const float left = center_row[c];
+                        const float right = center_row[c + 2];
+                        const float bottom_left = bottom_row[c];
+                        const float bottom = bottom_row[c + 1];
+                        const float bottom_right = bottom_row[c + 2];
+                        const float dx = (top_right + 2 * right + bottom_right) - (top_left + 2 * left + bottom_left);
+                        const float dy = (bottom_left + 2 * bottom + bottom_right) - (top_left + 2 * top + top_right);
+                        const glm::vec3 unit_normal = glm::normalize(glm::vec3{dx, dy, dz});
+                        if (channels == 2)
+                        {
+                            const glm::vec2 rg_normal = ((octahedral_encode(unit_normal) + 1.0f) / 2.0f) * 255.0f;
+                            normal[0] = static_cast<std::uint8_t>(rg_normal.x + 0.5f);
+                            normal[1] = static_cast<std::uint8_t>(rg_normal.y + 0.5f);
+                            continue;
+                        }
+                        const glm::vec3 rgb_normal = ((unit_normal + 1.0f) / 2.0f) * 255.0f;
+                        normal[0] = static_cast<std::uint8_t>(rgb_normal.x);
+                        normal[1] = static_cast<std::uint8_t>(rgb_normal.y);
+                        normal[2] = static_cast<std::uint8_t>(rgb_normal.z);
+                        normal[3] = 255;
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+template<typename T>
+Image<T> FractalNoiseGenerator::allocate_map(std::string_view file_name, std::size_t depth) const
+{
+    if (storage_directory_)
+    {
+        return Image<T>{*storage_directory_ / file_name, width_, height_, depth};
+    }
+    return Image<T>{width_, height_, depth};
+}
+
+void FractalNoiseGenerator::allocate_maps()
+{
+    // Maps are allocated on first use, so maps larger than the memory are never allocated in it
+    if (height_map_.pixels() == 0)
+    {
+        height_map_ = allocate_map<float>("height_map.f32", 1);
+    }
+    if (raw_height_map_.pixels() == 0)
+    {
+        raw_height_map_ = allocate_map<float>("raw_height_map.f32", 1);
+        accumulation_.valid = false;
+    }
+    if (normal_map_.pixels() == 0)
+    {
+        normal_map_ = allocate_map<std::uint8_t>("normal_map.u8", normal_channels(normal_encoding_));
+    }
+}
 
 FractalNoiseGenerator::FractalNoiseGenerator(std::uint32_t width, std::uint32_t height) :
-    width_{width}, height_{height}, height_map_{width, height}, normal_map_{width, height, 4}
+    width_{width}, height_{height}, height_map_{0, 0}, raw_height_map_{0, 0}, normal_map_{0, 0}
 {
     random_offsets_.reserve(4 * noise_settings.octaves);
+    generate_random_offsets();
 }
 
 void FractalNoiseGenerator::update(bool apply_hermite_interpolation)
 {
-    update_height_map(apply_hermite_interpolation);
-    update_normal_map();
+    allocate_maps();
+    prepare_random_offsets();
+
+    std::uint64_t key{0};
+    const bool use_cache{cache_ && !noise_graph_ && !hydraulic_erosion_ && !thermal_erosion_ && !storage_directory_};
+    if (use_cache)
+    {
+        const std::span<const glm::vec2> offsets{random_offsets_.data(),
+                                                 static_cast<std::size_t>(noise_settings.octaves)};
+        key = terrain_hash(noise_settings, offsets, width_, height_, apply_hermite_interpolation, normal_encoding_);
+        if (const auto maps = cache_->find(key))
+        {
+            height_map_ = maps->height_map;
+            normal_map_ = maps->normal_map;
+            return;
+        }
+    }
+
+    update_raw_height_map();
+    if (hydraulic_erosion_ || thermal_erosion_)
+    {
+        redistribute_heights(apply_hermite_interpolation);
+        erode_height_map();
+        update_normal_map();
+    }
+    else
+    {
+        compute_height_and_normal_maps(apply_hermite_interpolation);
+    }
+
+    if (use_cache)
+    {
+        cache_->insert(key, TerrainMaps{height_map_, normal_map_});
+    }
 }
 
 void FractalNoiseGenerator::update_height_map(bool apply_hermite_interpolation)
 {
-    generate_random_offsets();
+    allocate_maps();
+    prepare_random_offsets();
+    update_raw_height_map();
+    redistribute_heights(apply_hermite_interpolation);
+    erode_height_map();
+}
 
-    float min_height{std::numeric_limits<float>::max()};
-    float max_height{std::numeric_limits<float>::lowest()};
+void FractalNoiseGenerator::erode_height_map()
+{
+    if (hydraulic_erosion_)
+    {
+        height_map_.advise(AccessPattern::random);
+        erode_hydraulic(height_map_, *hydraulic_erosion_, workers_);
+    }
+    if (thermal_erosion_)
+    {
+        height_map_.advise(AccessPattern::sequential);
+        erode_thermal(height_map_, *thermal_erosion_, workers_);
+    }
+}
+
+void FractalNoiseGenerator::prepare_random_offsets()
+{
+    // Offsets are a pure function of the seed and the octave, so existing octaves keep theirs
+    random_offsets_.resize(noise_settings.octaves);
+    for (int i = 0; i < noise_settings.octaves; ++i)
+    {
+        random_offsets_[i] = noise_settings.offset + octave_offset(seed_, static_cast<std::uint32_t>(i));
+    }
+}
+
+void FractalNoiseGenerator::update_raw_height_map()
+{
+    if (noise_graph_ || !incremental_ || !can_reuse_accumulation())
+    {
+        accumulate_octaves();
+    }
+    else if (accumulation_.octaves != noise_settings.octaves)
+    {
+        update_accumulated_octaves();
+    }
+}
+
+bool FractalNoiseGenerator::can_reuse_accumulation() const
+{
+    if (!accumulation_.valid || accumulation_.noise_scale != noise_settings.noise_scale ||
+        accumulation_.lacunarity != noise_settings.lacunarity ||
+        accumulation_.persistance != noise_settings.persistance)
+    {
+        return false;
+    }
+
+    // Octaves present both before and after the update must use the same offsets
+    const auto shared_octaves = static_cast<std::size_t>(std::min(accumulation_.octaves, noise_settings.octaves));
+    return std::equal(accumulation_.offsets.cbegin(), accumulation_.offsets.cbegin() + shared_octaves,
+                      random_offsets_.cbegin());
+}
+
+void FractalNoiseGenerator::accumulate_octaves()
+{
     const float half_width{width_ / 2.0f};
     const float half_height{height_ / 2.0f};
+    const std::span<const glm::vec2> offsets{random_offsets_.data(), static_cast<std::size_t>(noise_settings.octaves)};
+    const std::vector<FractalNoiseOctave> octaves = fractal_noise_octaves(
+        offsets, noise_settings.noise_scale, noise_settings.lacunarity, noise_settings.persistance);
+
+    // Each band reduces its own min/max, which are merged after all bands finish
+    raw_height_map_.advise(AccessPattern::sequential);
+    std::vector<std::pair<float, float>> band_ranges(
+        band_count(height_, workers_), {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()});
+
+    parallel_for_bands(height_, workers_, [&](std::size_t band, std::size_t first_row, std::size_t last_row) {
+        auto& [min_height, max_height] = band_ranges[band];
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            const std::span<float> row{raw_height_map_.row(i), width_};
+            const glm::vec2 start{-half_width, static_cast<float>(i) - half_height};
+            if (noise_graph_)
+            {
+                noise_graph_->evaluate_row(row, start, 1.0f);
+            }
+            else
+            {
+                fractal_noise_row(row, start, 1.0f, octaves);
+            }
 
-    for (std::size_t i = 0; i < height_; ++i)
+            const auto [row_min, row_max] = std::minmax_element(row.begin(), row.end());
+            min_height = std::min(min_height, *row_min);
+            max_height = std::max(max_height, *row_max);
+        }
+    });
+
+    // A graph result can't be updated octave by octave
+    accumulation_ = Accumulation{
+        .valid = !noise_graph_,
+        .octaves = noise_settings.octaves,
+        .noise_scale = noise_settings.noise_scale,
+        .lacunarity = noise_settings.lacunarity,
+        .persistance = noise_settings.persistance,
+        .offsets = std::vector<glm::vec2>(offsets.begin(), offsets.end()),
+        .min_height = std::numeric_limits<float>::max(),
+        .max_height = std::numeric_limits<float>::lowest(),
+    };
+    for (const auto& [band_min, band_max] : band_ranges)
     {
-        for (std::size_t j = 0; j < width_; ++j)
+        accumulation_.min_height = std::min(accumulation_.min_height, band_min);
+        accumulation_.max_height = std::max(accumulation_.max_height, band_max);
+    }
+}
+
+void FractalNoiseGenerator::update_accumulated_octaves()
+{
+    const float half_width{width_ / 2.0f};
+    const float half_height{height_ / 2.0f};
+    const int previous_octaves{accumulation_.octaves};
+    const int octaves{noise_settings.octaves};
+
+    // Frequency and amplitude of every octave, computed as in the fBm loop
+    std::vector<std::pair<float, float>> octave_scales;
+    octave_scales.reserve(std::max(previous_octaves, octaves));
+    float frequency{1.0f};
+    float amplitude{1.0f};
+    for (int octave = 0; octave < std::max(previous_octaves, octaves); ++octave)
+    {
+        octave_scales.emplace_back(frequency, amplitude);
+        frequency *= noise_settings.lacunarity;
+        amplitude *= noise_settings.persistance;
+    }
+
+    raw_height_map_.advise(AccessPattern::sequential);
+    std::vector<std::pair<float, float>> band_ranges(
+        band_count(height_, workers_), {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()});
+
+    parallel_for_bands(height_, workers_, [&](std::size_t band, std::size_t first_row, std::size_t last_row) {
+        auto& [min_height, max_height] = band_ranges[band];
+        for (std::size_t i = first_row; i < last_row; ++i)
         {
-            float frequency{1.0f};
-            float amplitude{1.0f};
-            float noise_height{0.0f};
+            const std::span<float> row{raw_height_map_.row(i), width_};
+            const glm::vec2 start{-half_width, static_cast<float>(i) - half_height};
 
-            for (int octave = 0; octave < noise_settings.octaves; ++octave)
+            // Add new octaves in increasing order, or remove octaves in the reverse order they were added
+            for (int octave = previous_octaves; octave < octaves; ++octave)
             {
-                auto sample_point =
-                    (frequency / noise_settings.noise_scale) * glm::vec2{j - half_width, i - half_height};
-                sample_point += frequency * random_offsets_[octave];
-                noise_height += amplitude * glm::perlin(sample_point);
-                frequency *= noise_settings.lacunarity;
-                amplitude *= noise_settings.persistance;
+                const auto [octave_frequency, octave_amplitude] = octave_scales[octave];
+                octave_noise_row(row, start, 1.0f, random_offsets_[octave], octave_frequency, octave_amplitude,
+                                 noise_settings.noise_scale);
+            }
+            for (int octave = previous_octaves - 1; octave >= octaves; --octave)
+            {
+                const auto [octave_frequency, octave_amplitude] = octave_scales[octave];
+                octave_noise_row(row, start, 1.0f, accumulation_.offsets[octave], octave_frequency, -octave_amplitude,
+                                 noise_settings.noise_scale);
             }
 
-            height_map_.set(i, j, 0, noise_height);
-            max_height = std::max(max_height, noise_height);
-            min_height = std::min(min_height, noise_height);
+            const auto [row_min, row_max] = std::minmax_element(row.begin(), row.end());
+            min_height = std::min(min_height, *row_min);
+            max_height = std::max(max_height, *row_max);
         }
+    });
+
+    accumulation_.octaves = octaves;
+    accumulation_.offsets.assign(random_offsets_.cbegin(), random_offsets_.cbegin() + octaves);
+    accumulation_.min_height = std::numeric_limits<float>::max();
+    accumulation_.max_height = std::numeric_limits<float>::lowest();
+    for (const auto& [band_min, band_max] : band_ranges)
+    {
+        accumulation_.min_height = std::min(accumulation_.min_height, band_min);
+        accumulation_.max_height = std::max(accumulation_.max_height, band_max);
     }
+}
 
-    normalize_image(height_map_, max_height, min_height);
+void FractalNoiseGenerator::redistribute_heights(bool apply_hermite_interpolation)
+{
+    const HeightRedistribution redistribute{accumulation_.min_height,
+                                            accumulation_.max_height - accumulation_.min_height,
+                                            noise_settings.exponent, apply_hermite_interpolation ? &curve_ : nullptr};
+    raw_height_map_.advise(AccessPattern::sequential);
+    height_map_.advise(AccessPattern::sequential);
+    parallel_for_bands(height_, workers_, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            const float* raw_row = raw_height_map_.row(i);
+            float* row = height_map_.row(i);
+            std::transform(raw_row, raw_row + width_, row, redistribute);
+        }
+    });
+}
 
-    if (apply_hermite_interpolation)
+void FractalNoiseGenerator::compute_height_and_normal_maps(bool apply_hermite_interpolation)
+{
+    const HeightRedistribution redistribute{accumulation_.min_height,
+                                            accumulation_.max_height - accumulation_.min_height,
+                                            noise_settings.exponent, apply_hermite_interpolation ? &curve_ : nullptr};
+    raw_height_map_.advise(AccessPattern::sequential);
+    height_map_.advise(AccessPattern::sequential);
+    normal_map_.advise(AccessPattern::sequential);
+    normal_map_pass(raw_height_map_, &height_map_, normal_map_, workers_, redistribute);
+}
+
+Image<float> FractalNoiseGenerator::generate_tile(std::int64_t tile_x, std::int64_t tile_y, std::uint32_t tile_size,
+                                                  std::uint32_t lod, bool apply_hermite_interpolation) const
+{
+    Image<float> tile{tile_size, tile_size};
+    generate_tile(tile, tile_x, tile_y, lod, apply_hermite_interpolation);
+    return tile;
+}
+
+void FractalNoiseGenerator::generate_tile(Image<float>& tile, std::int64_t tile_x, std::int64_t tile_y,
+                                          std::uint32_t lod, bool apply_hermite_interpolation) const
+{
+    const auto tile_size = static_cast<std::uint32_t>(tile.width());
+    assert(tile_size >= 2 && tile.height() == tile_size && tile.depth() == 1);
+    assert(random_offsets_.size() >= static_cast<std::size_t>(noise_settings.octaves));
+
+    const std::span<const glm::vec2> offsets{random_offsets_.data(), static_cast<std::size_t>(noise_settings.octaves)};
+
+    // Tiles revisited with the same settings (e.g. when streaming) are copied from the cache
+    std::uint64_t key{0};
+    if (cache_)
     {
-        height_map_.transform([&curve = curve_](float noise_height) { return curve.evaluate(noise_height).y; });
+        key = terrain_hash(noise_settings, offsets, tile_size, tile_size, apply_hermite_interpolation,
+                           NormalEncoding::rgba, TileCoordinate{tile_x, tile_y, lod});
+        if (const auto maps = cache_->find(key))
+        {
+            for (std::size_t i = 0; i < tile_size; ++i)
+            {
+                std::copy_n(maps->height_map.row(i), tile_size, tile.row(i));
+            }
+            return;
+        }
+    }
+
+    const std::vector<FractalNoiseOctave> octaves = fractal_noise_octaves(
+        offsets, noise_settings.noise_scale, noise_settings.lacunarity, noise_settings.persistance);
+    const float bound{fractal_noise_bound(noise_settings.persistance, noise_settings.octaves)};
+
+    // World texel of the first sample of the tile; consecutive samples are 2^lod texels apart
+    const float step{static_cast<float>(std::int64_t{1} << lod)};
+    const float origin_x{static_cast<float>(tile_x * (tile_size - 1)) * step};
+    const float origin_y{static_cast<float>(tile_y * (tile_size - 1)) * step};
+
+    parallel_for_bands(tile_size, workers_, [&](std::size_t, std::size_t first_row, std::size_t last_row) {
+        for (std::size_t i = first_row; i < last_row; ++i)
+        {
+            const std::span<float> row{tile.row(i), tile_size};
+            fractal_noise_row(row, glm::vec2{origin_x, origin_y + static_cast<float>(i) * step}, step, octaves);
+            for (float& noise_height : row)
+            {
+                noise_height = std::clamp(0.5f + 0.5f * (noise_height / bound), 0.0f, 1.0f);
+            }
+            if (apply_hermite_interpolation)
+            {
+                curve_.evaluate(row, row);
+            }
+        }
+    });
+
+    if (cache_)
+    {
+        // Tiles have no normal map
+        cache_->insert(key, TerrainMaps{tile, Image<std::uint8_t>{0, 0}});
     }
 }
 
 void FractalNoiseGenerator::generate_random_offsets()
 {
-    random_offsets_.clear();
-    random_offsets_.resize(noise_settings.octaves);
-    for (int i = 0; i < noise_settings.octaves; ++i)
+    generate_random_offsets(static_cast<std::uint32_t>(noise_settings.seed));
+}
+
+void FractalNoiseGenerator::generate_random_offsets(std::uint64_t seed)
+{
+    seed_ = seed;
+    prepare_random_offsets();
+}
+
+void FractalNoiseGenerator::set_normal_encoding(NormalEncoding encoding)
+{
+    if (encoding != normal_encoding_)
     {
-        const glm::vec2 random_sample{glm::linearRand(-10000.0f, 10000.0f), -glm::linearRand(-10000.0f, 10000.0f)};
-        random_offsets_[i] = noise_settings.offset + random_sample;
+        normal_encoding_ = encoding;
+        // The next update allocates the map in the new format
+        normal_map_ = Image<std::uint8_t>{0, 0};
     }
 }
 
-void FractalNoiseGenerator::update_normal_map()
+NormalEncoding FractalNoiseGenerator::normal_encoding() const
 {
-    const float dz = 1.0f / 2.0f;
-    const auto float_to_uint = [](float channel_value) { return static_cast<std::uint8_t>(channel_value); };
-    for (int i = 0; i < static_cast<int>(height_); ++i)
+    return normal_encoding_;
+}
+
+void FractalNoiseGenerator::set_storage_directory(std::optional<std::filesystem::path> directory)
+{
+    if (directory)
     {
-        for (int j = 0; j < static_cast<int>(width_); ++j)
-        {
-            const float top_left = clamp_at_edge_height(i - 1, j - 1);
-            const float top = clamp_at_edge_height(i - 1, j);
-            const float top_right = clamp_at_edge_height(i - 1, j + 1);
-            const float left = clamp_at_edge_height(i, j - 1);
-            const float right = clamp_at_edge_height(i, j + 1);
-            const float bottom_left = clamp_at_edge_height(i + 1, j - 1);
-            const float bottom = clamp_at_edge_height(i + 1, j);
-            const float bottom_right = clamp_at_edge_height(i + 1, j + 1);
-            const float dx = (top_right + 2 * right + bottom_right) - (top_left + 2 * left + bottom_left);
-            const float dy = (bottom_left + 2 * bottom + bottom_right) - (top_left + 2 * top + top_right);
-            const glm::vec3 rgb_normal = cast_normal_to_rgb(glm::normalize(glm::vec3{dx, dy, dz}));
-            const glm::vec4 rgba_normal = glm::vec4{rgb_normal, 255.0};
-            normal_map_.set_transform(i, j, glm::value_ptr(rgba_normal), glm::value_ptr(rgba_normal) + 4,
-                                      float_to_uint);
-        }
+        std::filesystem::create_directories(*directory);
     }
+    storage_directory_ = std::move(directory);
+
+    // The next update allocates the maps in the new storage
+    height_map_ = Image<float>{0, 0};
+    raw_height_map_ = Image<float>{0, 0};
+    normal_map_ = Image<std::uint8_t>{0, 0};
+    accumulation_.valid = false;
+}
+
+const std::optional<std::filesystem::path>& FractalNoiseGenerator::storage_directory() const
+{
+    return storage_directory_;
 }
 
-float FractalNoiseGenerator::clamp_at_edge_height(int row, int column)
+std::uint64_t FractalNoiseGenerator::seed() const
 {
-    row = std::clamp(row, 0, static_cast<int>(height_ - 1));
-    column = std::clamp(column, 0, static_cast<int>(width_ - 1));
-    return height_map_.get(static_cast<std::size_t>(row), static_cast<std::size_t>(column));
+    return seed_;
 }
 
-glm::vec3 FractalNoiseGenerator::cast_normal_to_rgb(glm::vec3 vector)
+void FractalNoiseGenerator::update_normal_map()
 {
-    return ((vector + 1.0f) / 2.0f) * 255.0f;
+    allocate_maps();
+    height_map_.advise(AccessPattern::sequential);
+    normal_map_.advise(AccessPattern::sequential);
+    normal_map_pass(height_map_, nullptr, normal_map_, workers_, [](float height) { return height; });
 }
 
 void FractalNoiseGenerator::reset_settings()
 {
     static const NoiseSettings default_noise_settings{};
     noise_settings = default_noise_settings;
+    // The offsets follow the default seed, as in a new generator
+    generate_random_offsets();
     update();
 }
 
+void FractalNoiseGenerator::set_workers(std::size_t workers)
+{
+    workers_ = workers;
+}
+
+std::size_t FractalNoiseGenerator::workers() const
+{
+    return workers_;
+}
+
+void FractalNoiseGenerator::set_cache(std::shared_ptr<TerrainCache> cache)
+{
+    cache_ = std::move(cache);
+}
+
+void FractalNoiseGenerator::set_incremental(bool incremental)
+{
+    incremental_ = incremental;
+}
+
+bool FractalNoiseGenerator::incremental() const
+{
+    return incremental_;
+}
+
+void FractalNoiseGenerator::set_noise_graph(std::shared_ptr<const NoiseGraph> noise_graph)
+{
+    noise_graph_ = std::move(noise_graph);
+}
+
+const std::shared_ptr<const NoiseGraph>& FractalNoiseGenerator::noise_graph() const
+{
+    return noise_graph_;
+}
+
+void FractalNoiseGenerator::set_hydraulic_erosion(std::optional<HydraulicErosionSettings> settings)
+{
+    hydraulic_erosion_ = settings;
+}
+
+const std::optional<HydraulicErosionSettings>& FractalNoiseGenerator::hydraulic_erosion() const
+{
+    return hydraulic_erosion_;
+}
+
+void FractalNoiseGenerator::set_thermal_erosion(std::optional<ThermalErosionSettings> settings)
+{
+    thermal_erosion_ = settings;
+}
+
+const std::optional<ThermalErosionSettings>& FractalNoiseGenerator::thermal_erosion() const
+{
+    return thermal_erosion_;
+}
+
 const Image<float>& FractalNoiseGenerator::height_map() const
 {
     return height_map_;
@@ -130,7 +619,19 @@ const Image<std::uint8_t>& FractalNoiseGenerator::normal_map() const
     return normal_map_;
 }
 
+const CubicHermiteCurve& FractalNoiseGenerator::curve() const
+{
+    return curve_;
+}
+
 const std::vector<glm::vec2>& FractalNoiseGenerator::random_offsets() const
 {
     return random_offsets_;
+}
+
+Image<std::uint8_t> compute_normal_map(ImageView<float> height_map, NormalEncoding encoding, std::size_t workers)
+{
+    Image<std::uint8_t> normal_map{height_map.width(), height_map.height(), normal_channels(encoding)};
+    normal_map_pass(height_map, nullptr, normal_map, workers, [](float height) { return height; });
+    return normal_map;
 }
\ No newline at end of file
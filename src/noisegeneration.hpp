@@ -3,10 +3,19 @@
 
 #include <array>
 #include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <glm/glm.hpp>
 
+#include "erosion.hpp"
 #include "hermite.hpp"
 #include "image.hpp"
+#include "normalencoding.hpp"
+
+class NoiseGraph;
+class TerrainCache;
 
 /*
 Class to store data related to the Fractal Brownian Motion (fBM)
@@ -28,6 +37,7 @@ public:
 
     NoiseSettings noise_settings{};
 
+    // The maps are allocated by the first update, so a storage directory set before it is used from the start
     FractalNoiseGenerator(std::uint32_t width, std::uint32_t height);
     FractalNoiseGenerator(const FractalNoiseGenerator&) = default;
     FractalNoiseGenerator(FractalNoiseGenerator&&) = default;
@@ -37,11 +47,119 @@ public:
 
     void update(bool apply_hermite_interpolation = false);
     void update_height_map(bool apply_hermite_interpolation = false);
+
+    /*
+    Derive the random offsets of the octaves from a seed. The offsets are
+    a pure function of the seed, the octave and noise_settings.offset,
+    so generators with the same settings produce identical maps
+    regardless of call order or thread. Without an argument the seed is
+    taken from noise_settings.seed.
+    */
     void generate_random_offsets();
+    void generate_random_offsets(std::uint64_t seed);
+    std::uint64_t seed() const;
     void update_normal_map();
+
+    /*
+    Generate a square tile of the infinite terrain. Tiles are laid out on
+    a grid in world space, with neighbouring tiles sharing their border
+    samples, so the tile (tile_x, tile_y) covers the world texels
+    [tile_x * (tile_size - 1), (tile_x + 1) * (tile_size - 1)] (likewise
+    for y). At level of detail lod, samples are 2^lod world texels apart
+    and a tile spans 2^lod times as much terrain.
+
+    Heights are a pure function of the world position, the noise settings
+    and the random offsets: instead of rescaling by the min/max of the
+    generated data, the fBm sum is normalized by its bound
+    (see fractal_noise_bound). Tiles can therefore be generated in any
+    order or on different machines and still match along their seams.
+    */
+    Image<float> generate_tile(std::int64_t tile_x, std::int64_t tile_y, std::uint32_t tile_size,
+                               std::uint32_t lod = 0, bool apply_hermite_interpolation = false) const;
+    // Same, into an existing square image (e.g. a file-backed one) whose width is the tile size
+    void generate_tile(Image<float>& tile, std::int64_t tile_x, std::int64_t tile_y, std::uint32_t lod = 0,
+                       bool apply_hermite_interpolation = false) const;
+
     void reset_settings();
+
+    /*
+    Number of threads used by the CPU generation. The height map
+    is split into row bands, one per worker, and the result is
+    identical for any worker count. 0 means one worker per
+    hardware thread.
+    */
+    void set_workers(std::size_t workers);
+    std::size_t workers() const;
+
+    /*
+    Cache shared by generators to serve repeated updates and tiles without
+    recomputation. Each update and generate_tile looks the maps up by their
+    terrain_hash (with the tile coordinate for tiles) and stores the maps it
+    generates. Pass nullptr to disable caching (the default).
+    */
+    void set_cache(std::shared_ptr<TerrainCache> cache);
+
+    /*
+    Incremental mode reuses the raw fBm sum of the previous update when
+    only some settings changed: adding octaves evaluates just the new
+    octaves, removing octaves subtracts just the removed ones and changes
+    that only affect the redistribution (exponent or Hermite curve) skip
+    the noise evaluation entirely.
+    */
+    void set_incremental(bool incremental);
+    bool incremental() const;
+
+    /*
+    Replace the plain fBm by the output of a noise graph, evaluated in a
+    single fused pass per row. The graph result is then redistributed
+    like the fBm sum. Updates with a graph are always computed in full
+    and bypass the cache; generate_tile keeps using the plain fBm.
+    Pass nullptr to go back to the plain fBm (the default).
+    */
+    void set_noise_graph(std::shared_ptr<const NoiseGraph> noise_graph);
+    const std::shared_ptr<const NoiseGraph>& noise_graph() const;
+
+    /*
+    Optional hydraulic erosion stage, applied to the redistributed height
+    map before the normals are computed (see erode_hydraulic). It uses
+    the generator's workers. Updates with erosion bypass the cache.
+    */
+    void set_hydraulic_erosion(std::optional<HydraulicErosionSettings> settings);
+    const std::optional<HydraulicErosionSettings>& hydraulic_erosion() const;
+
+    /*
+    Optional thermal erosion stage, applied after the hydraulic erosion
+    (see erode_thermal). It uses the generator's workers. Updates with
+    erosion bypass the cache.
+    */
+    void set_thermal_erosion(std::optional<ThermalErosionSettings> settings);
+    const std::optional<ThermalErosionSettings>& thermal_erosion() const;
+
+    /*
+    Format of the normal map: RGBA (the default) or the two-channel
+    octahedral encoding, which halves its size. Changing the encoding
+    releases the normal map, which the next update reallocates and fills.
+    */
+    void set_normal_encoding(NormalEncoding encoding);
+    NormalEncoding normal_encoding() const;
+
+    /*
+    Keep the height, raw height and normal maps in memory-mapped files
+    (height_map.f32, raw_height_map.f32 and normal_map.u8) of a directory
+    instead of in memory, for maps larger than the physical memory. The
+    passes stream through the maps row by row and the OS pages them in
+    and out. Pass nullopt to go back to memory (the default). Changing the
+    storage releases the maps, which the next update reallocates and fills.
+    Updates with file-backed maps bypass the cache. Copies of the
+    generator hold their maps in memory but keep the directory, which
+    takes effect on their next reallocation.
+    */
+    void set_storage_directory(std::optional<std::filesystem::path> directory);
+    const std::optional<std::filesystem::path>& storage_directory() const;
+
     const Image<float>& height_map() const;
     const Image<std::uint8_t>& color_map() const;
+    const CubicHermiteCurve& curve() const;
     const Image<std::uint8_t>& normal_map() const;
     const std::vector<glm::vec2>& random_offsets() const;
 
@@ -49,14 +167,57 @@ private:
     const std::uint32_t width_{0};
     const std::uint32_t height_{0};
     Image<float> height_map_;
+    Image<float> raw_height_map_;
     Image<std::uint8_t> normal_map_;
     std::vector<glm::vec2> random_offsets_;
+    std::uint64_t seed_{0};
+    std::size_t workers_{1};
+    std::shared_ptr<TerrainCache> cache_{};
+    bool incremental_{false};
+    std::shared_ptr<const NoiseGraph> noise_graph_{};
+    std::optional<HydraulicErosionSettings> hydraulic_erosion_{};
+    std::optional<ThermalErosionSettings> thermal_erosion_{};
+    NormalEncoding normal_encoding_{NormalEncoding::rgba};
+    std::optional<std::filesystem::path> storage_directory_{};
+
+    // Parameters of the fBm sum currently accumulated in raw_height_map_
+    struct Accumulation
+    {
+        bool valid{false};
+        int octaves{0};
+        float noise_scale{0.0f};
+        float lacunarity{0.0f};
+        float persistance{0.0f};
+        std::vector<glm::vec2> offsets{};
+        float min_height{0.0f};
+        float max_height{0.0f};
+    };
+    Accumulation accumulation_{};
+
     CubicHermiteCurve curve_{std::vector<glm::vec2>{{0.0f, 0.0f}, {0.4f, 0.1f}, {1.0f, 1.0f}},
                              std::vector<glm::vec2>{{1.0f, 0.1f}, {1.0f, 0.1f}, {0.7f, 2.0f}},
                              std::vector<float>{0.0f, 0.4f, 1.0f}};
 
-    float clamp_at_edge_height(int row, int column);
-    glm::vec3 cast_normal_to_rgb(glm::vec3 vector);
+    template<typename T>
+    Image<T> allocate_map(std::string_view file_name, std::size_t depth) const;
+    void allocate_maps();
+    void prepare_random_offsets();
+    void update_raw_height_map();
+    bool can_reuse_accumulation() const;
+    void accumulate_octaves();
+    void update_accumulated_octaves();
+    void redistribute_heights(bool apply_hermite_interpolation);
+    void erode_height_map();
+    void compute_height_and_normal_maps(bool apply_hermite_interpolation);
 };
 
+/*
+Normal map of a height map, computed with the same Sobel stencil as
+FractalNoiseGenerator (e.g. for tiles from generate_tile). Texels
+outside the map take the height of the border. The height map can be a
+view of a padded image or of a rectangle of one.
+*/
+Image<std::uint8_t> compute_normal_map(ImageView<float> height_map, NormalEncoding encoding = NormalEncoding::rgba,
+                                       std::size_t workers = 1);
+
 #endif // NOISE_GENERATION_HPP
\ No newline at end of file
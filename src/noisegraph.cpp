@@ -0,0 +1,342 @@
+#include "noisegraph.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+#include "simd.hpp"
+
+namespace
+{
+
+float apply_curve(const CubicHermiteCurve& hermite_curve, float value)
+{
+    return hermite_curve.evaluate(std::clamp(value, 0.0f, 1.0f)).y;
+}
+
+template<std::size_t Lanes>
+simd::FloatBatch<Lanes> apply_curve(const CubicHermiteCurve& hermite_curve, simd::FloatBatch<Lanes> value)
+{
+    // The curve is piecewise, so the lanes go through its batch evaluation
+    using simd::max;
+    using simd::min;
+    const auto clamped = min(max(value, simd::FloatBatch<Lanes>{0.0f}), simd::FloatBatch<Lanes>{1.0f});
+    alignas(64) std::array<float, Lanes> lanes;
+    clamped.store(lanes.data());
+    hermite_curve.evaluate(lanes, lanes);
+    return simd::FloatBatch<Lanes>::load(lanes.data());
+}
+
+} // namespace
+
+NoiseGraph::Node NoiseGraph::fbm(const FractalSettings& settings)
+{
+    return push(NodeData{Operation::fbm, 0, 0, push_octaves(settings, 0), octave_count(settings)});
+}
+
+NoiseGraph::Node NoiseGraph::ridged(const FractalSettings& settings)
+{
+    return push(NodeData{Operation::ridged, 0, 0, push_octaves(settings, 0), octave_count(settings)});
+}
+
+NoiseGraph::Node NoiseGraph::billow(const FractalSettings& settings)
+{
+    return push(NodeData{Operation::billow, 0, 0, push_octaves(settings, 0), octave_count(settings)});
+}
+
+NoiseGraph::Node NoiseGraph::domain_warp(Node source, const FractalSettings& warp, float strength)
+{
+    check_node(source);
+    // The x and y displacements use consecutive octave ranges drawn from two streams
+    NodeData node{Operation::domain_warp, source, 0, push_octaves(warp, 1), octave_count(warp)};
+    push_octaves(warp, 2);
+    node.parameter = strength;
+    return push(node);
+}
+
+NoiseGraph::Node NoiseGraph::terrace(Node source, int steps)
+{
+    check_node(source);
+    if (steps < 1)
+    {
+        throw std::invalid_argument("Terrace needs at least one step");
+    }
+    NodeData node{Operation::terrace, source};
+    node.parameter = static_cast<float>(steps);
+    return push(node);
+}
+
+NoiseGraph::Node NoiseGraph::curve(Node source, CubicHermiteCurve hermite_curve)
+{
+    check_node(source);
+    NodeData node{Operation::curve, source};
+    node.curve = static_cast<std::uint32_t>(curves_.size());
+    curves_.push_back(std::move(hermite_curve));
+    return push(node);
+}
+
+NoiseGraph::Node NoiseGraph::constant(float value)
+{
+    NodeData node{Operation::constant};
+    node.parameter = value;
+    return push(node);
+}
+
+NoiseGraph::Node NoiseGraph::add(Node a, Node b)
+{
+    check_node(a);
+    check_node(b);
+    return push(NodeData{Operation::add, a, b});
+}
+
+NoiseGraph::Node NoiseGraph::multiply(Node a, Node b)
+{
+    check_node(a);
+    check_node(b);
+    return push(NodeData{Operation::multiply, a, b});
+}
+
+NoiseGraph::Node NoiseGraph::min(Node a, Node b)
+{
+    check_node(a);
+    check_node(b);
+    return push(NodeData{Operation::min, a, b});
+}
+
+NoiseGraph::Node NoiseGraph::max(Node a, Node b)
+{
+    check_node(a);
+    check_node(b);
+    return push(NodeData{Operation::max, a, b});
+}
+
+void NoiseGraph::set_output(Node node)
+{
+    check_node(node);
+    output_ = node;
+}
+
+NoiseGraph::Node NoiseGraph::output() const
+{
+    return output_;
+}
+
+std::size_t NoiseGraph::size() const
+{
+    return nodes_.size();
+}
+
+float NoiseGraph::evaluate(glm::vec2 point) const
+{
+    if (nodes_.empty())
+    {
+        return 0.0f;
+    }
+    const Plan graph_plan = plan();
+    std::vector<float> values(graph_plan.values);
+    return evaluate(graph_plan, output_, point.x, point.y, values.data());
+}
+
+void NoiseGraph::evaluate_row(std::span<float> row, glm::vec2 start, float step) const
+{
+    if (nodes_.empty())
+    {
+        std::fill(row.begin(), row.end(), 0.0f);
+        return;
+    }
+
+    using Batch = simd::NativeFloatBatch;
+
+    const Plan graph_plan = plan();
+    std::vector<Batch> batch_values(graph_plan.values);
+    std::vector<float> values(graph_plan.values);
+
+    alignas(64) float lane_steps[Batch::lanes];
+    for (std::size_t lane = 0; lane < Batch::lanes; ++lane)
+    {
+        lane_steps[lane] = static_cast<float>(lane);
+    }
+    const Batch lane_offsets = Batch::load(lane_steps);
+
+    std::size_t column{0};
+    for (; column + Batch::lanes <= row.size(); column += Batch::lanes)
+    {
+        const Batch x = Batch{start.x} + (Batch{static_cast<float>(column)} + lane_offsets) * Batch{step};
+        evaluate(graph_plan, output_, x, Batch{start.y}, batch_values.data()).store(&row[column]);
+    }
+
+    for (; column < row.size(); ++column)
+    {
+        row[column] =
+            evaluate(graph_plan, output_, start.x + static_cast<float>(column) * step, start.y, values.data());
+    }
+}
+
+NoiseGraph::Node NoiseGraph::push(NodeData node)
+{
+    nodes_.push_back(node);
+    output_ = static_cast<Node>(nodes_.size() - 1);
+    return output_;
+}
+
+std::uint32_t NoiseGraph::push_octaves(const FractalSettings& settings, std::uint64_t stream)
+{
+    std::vector<glm::vec2> offsets(octave_count(settings));
+    for (std::size_t i = 0; i < offsets.size(); ++i)
+    {
+        offsets[i] = settings.offset + octave_offset(settings.seed, static_cast<std::uint32_t>(i), stream);
+    }
+    const std::vector<FractalNoiseOctave> octaves =
+        fractal_noise_octaves(offsets, settings.noise_scale, settings.lacunarity, settings.persistance);
+
+    const auto first_octave = static_cast<std::uint32_t>(octaves_.size());
+    octaves_.insert(octaves_.end(), octaves.begin(), octaves.end());
+    return first_octave;
+}
+
+std::uint32_t NoiseGraph::octave_count(const FractalSettings& settings)
+{
+    return static_cast<std::uint32_t>(std::max(settings.octaves, 0));
+}
+
+void NoiseGraph::check_node(Node node) const
+{
+    if (node >= nodes_.size())
+    {
+        throw std::invalid_argument("Noise graph node doesn't exist");
+    }
+}
+
+NoiseGraph::Plan NoiseGraph::plan() const
+{
+    Plan graph_plan{std::vector<std::vector<Node>>(nodes_.size()), std::vector<std::size_t>(nodes_.size(), 0)};
+    graph_plan.values = nodes_.size() * schedule(graph_plan, output_);
+    return graph_plan;
+}
+
+std::size_t NoiseGraph::schedule(Plan& graph_plan, Node root) const
+{
+    if (graph_plan.levels[root] > 0)
+    {
+        return graph_plan.levels[root];
+    }
+
+    // Walk back from the root; inputs are always created before the nodes using them
+    std::vector<bool> needed(root + 1, false);
+    needed[root] = true;
+    std::vector<Node> nodes;
+    for (Node node = root + 1; node-- > 0;)
+    {
+        if (!needed[node])
+        {
+            continue;
+        }
+        nodes.push_back(node);
+        const NodeData& data = nodes_[node];
+        switch (data.operation)
+        {
+        case Operation::terrace:
+        case Operation::curve:
+            needed[data.a] = true;
+            break;
+        case Operation::add:
+        case Operation::multiply:
+        case Operation::min:
+        case Operation::max:
+            needed[data.a] = true;
+            needed[data.b] = true;
+            break;
+        default:
+            // Sources have no inputs and the source of a domain warp is scheduled on its own
+            break;
+        }
+    }
+    std::reverse(nodes.begin(), nodes.end());
+
+    std::size_t levels{1};
+    for (const Node node : nodes)
+    {
+        if (nodes_[node].operation == Operation::domain_warp)
+        {
+            levels = std::max(levels, 1 + schedule(graph_plan, nodes_[node].a));
+        }
+    }
+    graph_plan.schedules[root] = std::move(nodes);
+    graph_plan.levels[root] = levels;
+    return levels;
+}
+
+template<typename Value>
+Value NoiseGraph::evaluate(const Plan& graph_plan, Node root, Value x, Value y, Value* values) const
+{
+    for (const Node node : graph_plan.schedules[root])
+    {
+        values[node] = evaluate_node(graph_plan, node, x, y, values);
+    }
+    return values[root];
+}
+
+template<typename Value>
+Value NoiseGraph::evaluate_node(const Plan& graph_plan, Node node, Value x, Value y, Value* values) const
+{
+    using simd::abs;
+    using simd::floor;
+    using simd::max;
+    using simd::min;
+
+    const NodeData& data = nodes_[node];
+    const auto fractal = [this, &data](Value sample_x, Value sample_y, std::uint32_t first_octave, auto&& shape) {
+        Value noise_height{0.0f};
+        for (std::uint32_t octave = first_octave; octave < first_octave + data.octave_count; ++octave)
+        {
+            const FractalNoiseOctave& constants = octaves_[octave];
+            const Value noise = gradient_noise(Value{constants.scale} * sample_x + Value{constants.offset_x},
+                                               Value{constants.scale} * sample_y + Value{constants.offset_y});
+            noise_height = noise_height + Value{constants.amplitude} * shape(noise);
+        }
+        return noise_height;
+    };
+
+    switch (data.operation)
+    {
+    case Operation::fbm:
+        return fractal(x, y, data.first_octave, [](Value noise) { return noise; });
+    case Operation::ridged:
+        return fractal(x, y, data.first_octave, [](Value noise) {
+            const Value signal = Value{1.0f} - abs(noise);
+            return signal * signal;
+        });
+    case Operation::billow:
+        return fractal(x, y, data.first_octave,
+                       [](Value noise) { return Value{2.0f} * abs(noise) - Value{1.0f}; });
+    case Operation::domain_warp: {
+        const auto identity = [](Value noise) { return noise; };
+        const Value warp_x = fractal(x, y, data.first_octave, identity);
+        const Value warp_y = fractal(x, y, data.first_octave + data.octave_count, identity);
+        // The source is evaluated at the warped coordinates with the values of the next level
+        return evaluate(graph_plan, data.a, x + Value{data.parameter} * warp_x, y + Value{data.parameter} * warp_y,
+                        values + nodes_.size());
+    }
+    case Operation::terrace: {
+        const Value steps{data.parameter};
+        const Value level = values[data.a] * steps;
+        const Value step = floor(level);
+        const Value riser = level - step;
+        return (step + riser * riser * (Value{3.0f} - Value{2.0f} * riser)) / steps;
+    }
+    case Operation::curve:
+        return apply_curve(curves_[data.curve], values[data.a]);
+    case Operation::constant:
+        return Value{data.parameter};
+    case Operation::add:
+        return values[data.a] + values[data.b];
+    case Operation::multiply:
+        return values[data.a] * values[data.b];
+    case Operation::min:
+        return min(values[data.a], values[data.b]);
+    case Operation::max:
+        return max(values[data.a], values[data.b]);
+    }
+    return Value{0.0f};
+}
\ No newline at end of file
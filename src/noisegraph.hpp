@@ -0,0 +1,144 @@
+#ifndef NOISE_GRAPH_HPP
+#define NOISE_GRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gradientnoise.hpp"
+#include "hermite.hpp"
+
+/*
+Description of a height function built from noise sources (fBm,
+ridged and billow fractals), coordinate transforms (domain warping),
+height transforms (terracing, Hermite curves) and combinators (add,
+multiply, min, max). Nodes are created through the member functions,
+which return a handle to the new node, and may only refer to nodes
+created before them, so the graph is always acyclic.
+
+The graph is evaluated per texel in a single fused traversal: a row is
+processed in SIMD batches and every batch evaluates the nodes reachable
+from the output in creation order, which is topological, keeping one
+value per node. A node shared by several parents is computed once per
+batch; only the sources of domain warps are evaluated again, at the
+warped coordinates. No intermediate images are allocated, so memory use
+doesn't depend on the image size.
+*/
+class NoiseGraph
+{
+public:
+    using Node = std::uint32_t;
+
+    // Parameters of a fractal source; offsets are derived from seed as in FractalNoiseGenerator
+    struct FractalSettings
+    {
+        float noise_scale{3.0f};
+        float lacunarity{2.0f};
+        float persistance{0.5f};
+        int octaves{8};
+        glm::vec2 offset{0.0f};
+        std::uint64_t seed{0};
+    };
+
+    // Sum of octaves of gradient noise, same as the fBm of FractalNoiseGenerator
+    Node fbm(const FractalSettings& settings);
+    // Sum of octaves of (1 - |noise|)^2, giving sharp ridges
+    Node ridged(const FractalSettings& settings);
+    // Sum of octaves of 2|noise| - 1, giving rounded, billowy shapes
+    Node billow(const FractalSettings& settings);
+
+    /*
+    Evaluate source at coordinates displaced by strength times a pair of
+    fBm values, computed with the given settings on two independent
+    random streams.
+    */
+    Node domain_warp(Node source, const FractalSettings& warp, float strength);
+
+    // Quantize source into terraces of height 1 / steps with smoothed risers
+    Node terrace(Node source, int steps);
+    // Remap source, clamped to [0, 1], through a CubicHermiteCurve as in FractalNoiseGenerator
+    Node curve(Node source, CubicHermiteCurve hermite_curve);
+
+    Node constant(float value);
+    Node add(Node a, Node b);
+    Node multiply(Node a, Node b);
+    Node min(Node a, Node b);
+    Node max(Node a, Node b);
+
+    // Node evaluated by evaluate and evaluate_row; defaults to the last node created
+    void set_output(Node node);
+    Node output() const;
+    std::size_t size() const;
+
+    float evaluate(glm::vec2 point) const;
+
+    /*
+    Fill a row with the output of the graph. Sample n of the row is
+    located at (start.x + n * step, start.y), as in fractal_noise_row.
+    */
+    void evaluate_row(std::span<float> row, glm::vec2 start, float step) const;
+
+private:
+    enum class Operation
+    {
+        fbm,
+        ridged,
+        billow,
+        domain_warp,
+        terrace,
+        curve,
+        constant,
+        add,
+        multiply,
+        min,
+        max
+    };
+
+    struct NodeData
+    {
+        Operation operation;
+        Node a{0};
+        Node b{0};
+        // Range of octaves_ used by fractal sources and domain warps
+        std::uint32_t first_octave{0};
+        std::uint32_t octave_count{0};
+        // Constant value, warp strength or number of terrace steps
+        float parameter{0.0f};
+        // Index into curves_ of a curve node
+        std::uint32_t curve{0};
+    };
+
+    // Order of evaluation of the nodes of a graph, built before evaluating it
+    struct Plan
+    {
+        // Nodes computed, in creation order, to evaluate a root: the output and the sources of domain warps
+        std::vector<std::vector<Node>> schedules;
+        // Levels of domain warps nested under each scheduled root, counting the root's own level
+        std::vector<std::size_t> levels;
+        // Values kept per batch: one per node for each level
+        std::size_t values{0};
+    };
+
+    std::vector<NodeData> nodes_;
+    std::vector<FractalNoiseOctave> octaves_;
+    std::vector<CubicHermiteCurve> curves_;
+    Node output_{0};
+
+    Node push(NodeData node);
+    std::uint32_t push_octaves(const FractalSettings& settings, std::uint64_t stream);
+    static std::uint32_t octave_count(const FractalSettings& settings);
+    void check_node(Node node) const;
+
+    Plan plan() const;
+    std::size_t schedule(Plan& plan, Node root) const;
+
+    template<typename Value>
+    Value evaluate(const Plan& plan, Node root, Value x, Value y, Value* values) const;
+    template<typename Value>
+    Value evaluate_node(const Plan& plan, Node node, Value x, Value y, Value* values) const;
+};
+
+#endif // NOISE_GRAPH_HPP
\ No newline at end of file
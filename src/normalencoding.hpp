@@ -0,0 +1,50 @@
+#ifndef NORMAL_ENCODING_HPP
+#define NORMAL_ENCODING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/*
+Storage format of normal maps: plain RGBA with the normal in RGB, or the
+two-channel octahedral encoding, which maps the unit sphere onto the
+[-1, 1]^2 square and needs half the memory and bandwidth.
+*/
+enum class NormalEncoding : std::uint8_t
+{
+    rgba,
+    octahedral
+};
+
+inline std::size_t normal_channels(NormalEncoding encoding)
+{
+    return encoding == NormalEncoding::octahedral ? 2 : 4;
+}
+
+// Octahedral encoding of a unit vector; the lower hemisphere is folded over the diagonals
+inline glm::vec2 octahedral_encode(glm::vec3 normal)
+{
+    const glm::vec2 projected =
+        glm::vec2{normal.x, normal.y} / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+    if (normal.z >= 0.0f)
+    {
+        return projected;
+    }
+    return glm::vec2{(1.0f - glm::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+                     (1.0f - glm::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f)};
+}
+
+// Inverse of octahedral_encode; the result is normalized
+inline glm::vec3 octahedral_decode(glm::vec2 encoded)
+{
+    glm::vec3 normal{encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y)};
+    if (normal.z < 0.0f)
+    {
+        normal.x = (1.0f - glm::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f);
+        normal.y = (1.0f - glm::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(normal);
+}
+
+#endif // NORMAL_ENCODING_HPP
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+Number of hardware threads available, or 1 if it can't be determined.
+*/
+inline std::size_t hardware_workers()
+{
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+/*
+Number of bands used to split the given number of rows across workers.
+A worker count of 0 means one worker per hardware thread.
+*/
+inline std::size_t band_count(std::size_t rows, std::size_t workers)
+{
+    if (workers == 0)
+    {
+        workers = hardware_workers();
+    }
+    return std::max<std::size_t>(1, std::min(rows, workers));
+}
+
+/*
+Split the rows [0, rows) into contiguous bands of (almost) equal size and
+invoke function(band, first_row, last_row) for each band, with last_row
+being exclusive. Band 0 runs on the calling thread and each remaining band
+runs on its own thread; the call returns once every band has finished.
+Bands never overlap, so the function may freely write to its own rows.
+*/
+template<typename Function>
+void parallel_for_bands(std::size_t rows, std::size_t workers, Function&& function)
+{
+    const std::size_t bands = band_count(rows, workers);
+    const auto band_begin = [rows, bands](std::size_t band) { return (rows * band) / bands; };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(bands - 1);
+    for (std::size_t band = 1; band < bands; ++band)
+    {
+        threads.emplace_back([&function, band, first_row = band_begin(band), last_row = band_begin(band + 1)]() {
+            function(band, first_row, last_row);
+        });
+    }
+
+    function(std::size_t{0}, band_begin(0), band_begin(1));
+}
+
+#endif // PARALLEL_HPP
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+/*
+Stateless counter-based random numbers. Every value is a pure function
+of a (seed, stream, counter) triple, scrambled by the SplitMix64
+finalizer, so there is no hidden generator state: values can be drawn in
+any order, from any thread or on any machine and always come out the
+same. Streams separate independent sequences under one seed (e.g. one
+per tile or per worker) and the counter indexes values within a stream.
+*/
+
+// SplitMix64 finalizer: a bijective 64-bit mix with full avalanche
+inline std::uint64_t mix_bits(std::uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+inline std::uint64_t random_bits(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter)
+{
+    return mix_bits(mix_bits(mix_bits(seed) ^ stream) ^ counter);
+}
+
+// Uniform float in [0, 1), built from the top 24 bits so every value is exactly representable
+inline float random_float(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter)
+{
+    return static_cast<float>(random_bits(seed, stream, counter) >> 40) * (1.0f / 16777216.0f);
+}
+
+// Uniform float in [min, max)
+inline float random_float(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter, float min, float max)
+{
+    return min + (max - min) * random_float(seed, stream, counter);
+}
+
+// Stream identifier for a 2D grid cell such as a terrain tile
+inline std::uint64_t random_stream(std::int64_t x, std::int64_t y)
+{
+    return mix_bits(static_cast<std::uint64_t>(x)) ^ static_cast<std::uint64_t>(y);
+}
+
+#endif // RANDOM_HPP
\ No newline at end of file
@@ -70,14 +70,15 @@ const std::string& Shader::shader_typename(Shader::Type type)
     return shader_types.at(type);
 }
 
-ShaderProgram::ShaderProgram(std::initializer_list<std::pair<std::string_view, Shader::Type>> initializer) :
+ShaderProgram::ShaderProgram(std::initializer_list<std::pair<std::string_view, Shader::Type>> initializer,
+                             std::string_view definitions) :
     program_id_{glCreateProgram()}
 {
     std::vector<Shader> shaders;
     shaders.reserve(initializer.size());
     for (const auto& [filepath, shader_type] : initializer)
     {
-        shaders.emplace_back(load_shader_from_file(filepath, shader_type));
+        shaders.emplace_back(load_shader_from_file(filepath, shader_type, definitions));
         glAttachShader(program_id_, shaders.back().identifier());
     }
 
@@ -92,7 +93,7 @@ ShaderProgram::ShaderProgram(std::initializer_list<std::pair<std::string_view, S
     retrieve_uniforms();
 }
 
-Shader load_shader_from_file(std::string_view filepath, Shader::Type type)
+Shader load_shader_from_file(std::string_view filepath, Shader::Type type, std::string_view definitions)
 {
     std::ifstream shader_file{filepath.data()};
     if (!shader_file.is_open())
@@ -104,7 +105,8 @@ Shader load_shader_from_file(std::string_view filepath, Shader::Type type)
 
     std::stringstream source_code_stream;
     source_code_stream << shader_file.rdbuf();
-    return Shader{process_shader_include(source_code_stream.str(), std::filesystem::path{filepath}), type};
+    std::string source_code = process_shader_include(source_code_stream.str(), std::filesystem::path{filepath});
+    return Shader{insert_shader_definitions(std::move(source_code), definitions), type};
 }
 
 std::string process_shader_include(std::string shader_source, std::filesystem::path shader_path)
@@ -128,6 +130,26 @@ std::string process_shader_include(std::string shader_source, std::filesystem::p
     return shader_source;
 }
 
+std::string insert_shader_definitions(std::string shader_source, std::string_view definitions)
+{
+    if (definitions.empty())
+    {
+        return shader_source;
+    }
+
+    // GLSL requires #version to come first, so definitions go on the line after it
+    const auto version_position = shader_source.find("#version");
+    const auto line_end = version_position == std::string::npos ? std::string::npos
+                                                                : shader_source.find('\n', version_position);
+    if (line_end == std::string::npos)
+    {
+        return std::string{definitions} + "\n" + shader_source;
+    }
+
+    shader_source.insert(line_end + 1, std::string{definitions} + "\n");
+    return shader_source;
+}
+
 void check_shader_program_link_status(std::uint32_t shader_program_id,
                                       std::initializer_list<std::pair<std::string_view, Shader::Type>> shader_data)
 {
@@ -259,6 +281,13 @@ void ShaderProgram::set_vec4_uniform(const std::string& uniform_name, const glm:
     glProgramUniform4fv(program_id_, uniform_locations_[uniform_name], 1, glm::value_ptr(vector));
 }
 
+void ShaderProgram::set_vec4_array_uniform(const std::string& uniform_name, const std::vector<glm::vec4>& value,
+                                           GLsizei count)
+{
+    assert(uniform_locations_.contains(uniform_name));
+    glProgramUniform4fv(program_id_, uniform_locations_[uniform_name], count, glm::value_ptr(value.front()));
+}
+
 void ShaderProgram::set_mat4_uniform(const std::string& uniform_name, const glm::mat4& matrix)
 {
     assert(uniform_locations_.contains(uniform_name));
@@ -44,7 +44,13 @@ class ShaderProgram
 {
 public:
     ShaderProgram() = default;
-    explicit ShaderProgram(std::initializer_list<std::pair<std::string_view, Shader::Type>> initializer);
+    /*
+    Compile and link the given shader files. definitions is inserted right
+    after the #version directive of every shader, e.g. to pass #define
+    lines selecting formats or features.
+    */
+    explicit ShaderProgram(std::initializer_list<std::pair<std::string_view, Shader::Type>> initializer,
+                           std::string_view definitions = {});
     ShaderProgram(const ShaderProgram&) = delete;
     ShaderProgram(ShaderProgram&& other) noexcept;
     ShaderProgram& operator=(const ShaderProgram&) = delete;
@@ -63,6 +69,7 @@ public:
     void set_vec3_uniform(const std::string& uniform_name, float x, float y, float z);
     void set_vec3_uniform(const std::string& uniform_name, const glm::vec3& vector);
     void set_vec4_uniform(const std::string& uniform_name, const glm::vec4& vector);
+    void set_vec4_array_uniform(const std::string& uniform_name, const std::vector<glm::vec4>& value, GLsizei count);
     void set_mat4_uniform(const std::string& uniform_name, const glm::mat4& transform);
 
 private:
@@ -74,10 +81,11 @@ private:
 
 // Auxiliary free functions
 void check_shader_compilation(std::uint32_t shader_id, std::string_view shader_type);
-Shader load_shader_from_file(std::string_view filepath, Shader::Type type);
+Shader load_shader_from_file(std::string_view filepath, Shader::Type type, std::string_view definitions = {});
 void check_shader_program_link_status(std::uint32_t shader_program_id,
                                       std::initializer_list<std::pair<std::string_view, Shader::Type>> shader_data);
 std::string process_shader_include(std::string shader_source, std::filesystem::path shader_path);
+std::string insert_shader_definitions(std::string shader_source, std::string_view definitions);
 
 template <typename T>
 constexpr std::underlying_type_t<T> to_underlying(T enumerator) noexcept
@@ -0,0 +1,527 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TERRAIN_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#endif
+
+#if defined(__AVX__) || defined(__AVX512F__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// Half-precision conversions; F16C ships with every AVX2 processor, and MSVC doesn't report it separately
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define TERRAIN_SIMD_F16C
+#endif
+
+/*
+Thin wrappers over SIMD registers of 4 (SSE2), 8 (AVX/AVX2) and
+16 (AVX-512) single-precision lanes. Each batch type supports the
+same set of operations, so kernels can be written once as templates
+and instantiated for any lane count. Lane counts without hardware
+support fall back to a plain array processed one lane at a time.
+All operations are performed lane-wise with IEEE rounding, so a kernel
+evaluated on a batch produces the same values as on scalar floats.
+*/
+namespace simd
+{
+
+template<std::size_t Lanes>
+struct FloatBatch
+{
+    static constexpr std::size_t lanes = Lanes;
+    std::array<float, Lanes> value{};
+
+    FloatBatch() = default;
+    FloatBatch(float scalar)
+    {
+        value.fill(scalar);
+    }
+
+    static FloatBatch load(const float* data)
+    {
+        FloatBatch batch;
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            batch.value[lane] = data[lane];
+        }
+        return batch;
+    }
+
+    void store(float* data) const
+    {
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            data[lane] = value[lane];
+        }
+    }
+
+    // Store the lanes converted to integers, rounded toward zero; lanes must be within the int32 range
+    void store_truncated(std::int32_t* data) const
+    {
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            data[lane] = static_cast<std::int32_t>(value[lane]);
+        }
+    }
+
+    template<typename Function>
+    friend FloatBatch apply(FloatBatch a, FloatBatch b, Function&& function)
+    {
+        FloatBatch result;
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            result.value[lane] = function(a.value[lane], b.value[lane]);
+        }
+        return result;
+    }
+
+    friend FloatBatch operator+(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return x + y; });
+    }
+
+    friend FloatBatch operator-(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return x - y; });
+    }
+
+    friend FloatBatch operator*(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return x * y; });
+    }
+
+    friend FloatBatch operator/(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return x / y; });
+    }
+
+    friend FloatBatch min(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return y < x ? y : x; });
+    }
+
+    friend FloatBatch max(FloatBatch a, FloatBatch b)
+    {
+        return apply(a, b, [](float x, float y) { return x < y ? y : x; });
+    }
+
+    friend FloatBatch floor(FloatBatch a)
+    {
+        return apply(a, a, [](float x, float) { return std::floor(x); });
+    }
+
+    friend FloatBatch abs(FloatBatch a)
+    {
+        return apply(a, a, [](float x, float) { return std::fabs(x); });
+    }
+
+    friend float horizontal_min(FloatBatch a)
+    {
+        float result{a.value[0]};
+        for (std::size_t lane = 1; lane < Lanes; ++lane)
+        {
+            result = a.value[lane] < result ? a.value[lane] : result;
+        }
+        return result;
+    }
+
+    friend float horizontal_max(FloatBatch a)
+    {
+        float result{a.value[0]};
+        for (std::size_t lane = 1; lane < Lanes; ++lane)
+        {
+            result = result < a.value[lane] ? a.value[lane] : result;
+        }
+        return result;
+    }
+};
+
+#ifdef TERRAIN_SIMD_SSE2
+template<>
+struct FloatBatch<4>
+{
+    static constexpr std::size_t lanes = 4;
+    __m128 value;
+
+    FloatBatch() : value{_mm_setzero_ps()}
+    {
+    }
+    FloatBatch(float scalar) : value{_mm_set1_ps(scalar)}
+    {
+    }
+    FloatBatch(__m128 vector) : value{vector}
+    {
+    }
+
+    static FloatBatch load(const float* data)
+    {
+        return _mm_loadu_ps(data);
+    }
+
+    void store(float* data) const
+    {
+        _mm_storeu_ps(data, value);
+    }
+
+    void store_truncated(std::int32_t* data) const
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_cvttps_epi32(value));
+    }
+
+    friend FloatBatch operator+(FloatBatch a, FloatBatch b)
+    {
+        return _mm_add_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator-(FloatBatch a, FloatBatch b)
+    {
+        return _mm_sub_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator*(FloatBatch a, FloatBatch b)
+    {
+        return _mm_mul_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator/(FloatBatch a, FloatBatch b)
+    {
+        return _mm_div_ps(a.value, b.value);
+    }
+
+    friend FloatBatch min(FloatBatch a, FloatBatch b)
+    {
+        return _mm_min_ps(a.value, b.value);
+    }
+
+    friend FloatBatch max(FloatBatch a, FloatBatch b)
+    {
+        return _mm_max_ps(a.value, b.value);
+    }
+
+    friend FloatBatch floor(FloatBatch a)
+    {
+#if defined(__SSE4_1__) || defined(__AVX__)
+        return _mm_floor_ps(a.value);
+#else
+        // Truncate towards zero and correct negative non-integers. Values with a
+        // magnitude of 2^23 or more are already integers and can't be converted.
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.value));
+        const __m128 corrected = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.value), _mm_set1_ps(1.0f)));
+        const __m128 is_small = _mm_cmplt_ps(abs(a).value, _mm_set1_ps(8388608.0f));
+        return _mm_or_ps(_mm_and_ps(is_small, corrected), _mm_andnot_ps(is_small, a.value));
+#endif
+    }
+
+    friend FloatBatch abs(FloatBatch a)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value);
+    }
+
+    friend float horizontal_min(FloatBatch a)
+    {
+        __m128 reduced = _mm_min_ps(a.value, _mm_shuffle_ps(a.value, a.value, _MM_SHUFFLE(1, 0, 3, 2)));
+        reduced = _mm_min_ps(reduced, _mm_shuffle_ps(reduced, reduced, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(reduced);
+    }
+
+    friend float horizontal_max(FloatBatch a)
+    {
+        __m128 reduced = _mm_max_ps(a.value, _mm_shuffle_ps(a.value, a.value, _MM_SHUFFLE(1, 0, 3, 2)));
+        reduced = _mm_max_ps(reduced, _mm_shuffle_ps(reduced, reduced, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(reduced);
+    }
+};
+#endif // TERRAIN_SIMD_SSE2
+
+#ifdef __AVX__
+template<>
+struct FloatBatch<8>
+{
+    static constexpr std::size_t lanes = 8;
+    __m256 value;
+
+    FloatBatch() : value{_mm256_setzero_ps()}
+    {
+    }
+    FloatBatch(float scalar) : value{_mm256_set1_ps(scalar)}
+    {
+    }
+    FloatBatch(__m256 vector) : value{vector}
+    {
+    }
+
+    static FloatBatch load(const float* data)
+    {
+        return _mm256_loadu_ps(data);
+    }
+
+    void store(float* data) const
+    {
+        _mm256_storeu_ps(data, value);
+    }
+
+    void store_truncated(std::int32_t* data) const
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm256_cvttps_epi32(value));
+    }
+
+    friend FloatBatch operator+(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_add_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator-(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_sub_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator*(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_mul_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator/(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_div_ps(a.value, b.value);
+    }
+
+    friend FloatBatch min(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_min_ps(a.value, b.value);
+    }
+
+    friend FloatBatch max(FloatBatch a, FloatBatch b)
+    {
+        return _mm256_max_ps(a.value, b.value);
+    }
+
+    friend FloatBatch floor(FloatBatch a)
+    {
+        return _mm256_floor_ps(a.value);
+    }
+
+    friend FloatBatch abs(FloatBatch a)
+    {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value);
+    }
+
+    friend float horizontal_min(FloatBatch a)
+    {
+        return horizontal_min(
+            FloatBatch<4>{_mm_min_ps(_mm256_castps256_ps128(a.value), _mm256_extractf128_ps(a.value, 1))});
+    }
+
+    friend float horizontal_max(FloatBatch a)
+    {
+        return horizontal_max(
+            FloatBatch<4>{_mm_max_ps(_mm256_castps256_ps128(a.value), _mm256_extractf128_ps(a.value, 1))});
+    }
+};
+#endif // __AVX__
+
+#ifdef __AVX512F__
+template<>
+struct FloatBatch<16>
+{
+    static constexpr std::size_t lanes = 16;
+    __m512 value;
+
+    FloatBatch() : value{_mm512_setzero_ps()}
+    {
+    }
+    FloatBatch(float scalar) : value{_mm512_set1_ps(scalar)}
+    {
+    }
+    FloatBatch(__m512 vector) : value{vector}
+    {
+    }
+
+    static FloatBatch load(const float* data)
+    {
+        return _mm512_loadu_ps(data);
+    }
+
+    void store(float* data) const
+    {
+        _mm512_storeu_ps(data, value);
+    }
+
+    void store_truncated(std::int32_t* data) const
+    {
+        _mm512_storeu_si512(data, _mm512_cvttps_epi32(value));
+    }
+
+    friend FloatBatch operator+(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_add_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator-(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_sub_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator*(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_mul_ps(a.value, b.value);
+    }
+
+    friend FloatBatch operator/(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_div_ps(a.value, b.value);
+    }
+
+    friend FloatBatch min(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_min_ps(a.value, b.value);
+    }
+
+    friend FloatBatch max(FloatBatch a, FloatBatch b)
+    {
+        return _mm512_max_ps(a.value, b.value);
+    }
+
+    friend FloatBatch floor(FloatBatch a)
+    {
+        return _mm512_mask_roundscale_ps(a.value, 0xFFFF, a.value, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    }
+
+    friend FloatBatch abs(FloatBatch a)
+    {
+        return _mm512_abs_ps(a.value);
+    }
+
+    friend float horizontal_min(FloatBatch a)
+    {
+        return _mm512_reduce_min_ps(a.value);
+    }
+
+    friend float horizontal_max(FloatBatch a)
+    {
+        return _mm512_reduce_max_ps(a.value);
+    }
+};
+#endif // __AVX512F__
+
+// Widest batch with hardware support on the target instruction set
+#if defined(__AVX512F__)
+inline constexpr std::size_t native_lanes = 16;
+#elif defined(__AVX__)
+inline constexpr std::size_t native_lanes = 8;
+#elif defined(TERRAIN_SIMD_SSE2)
+inline constexpr std::size_t native_lanes = 4;
+#else
+inline constexpr std::size_t native_lanes = 1;
+#endif
+
+using NativeFloatBatch = FloatBatch<native_lanes>;
+
+/*
+IEEE binary16 bits of a float, rounded to nearest even. Values beyond the
+half range become infinities, NaNs stay NaNs. Subnormal halves are
+rounded by a float addition that aligns their mantissa bits, so the FPU
+does the rounding.
+*/
+inline std::uint16_t to_half(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint32_t sign{bits & 0x80000000u};
+    bits ^= sign;
+
+    std::uint32_t result;
+    if (bits >= (143u << 23))
+    {
+        // At least 2^16: infinity, or a quiet NaN
+        result = bits > (255u << 23) ? 0x7e00u : 0x7c00u;
+    }
+    else if (bits < (113u << 23))
+    {
+        // Below 2^-14: adding 0.5 moves the 10 mantissa bits of the half to the bottom of the float
+        constexpr std::uint32_t magic_bits{126u << 23};
+        float magic;
+        std::memcpy(&magic, &magic_bits, sizeof(magic));
+        float aligned;
+        std::memcpy(&aligned, &bits, sizeof(aligned));
+        aligned += magic;
+        std::memcpy(&result, &aligned, sizeof(result));
+        result -= magic_bits;
+    }
+    else
+    {
+        // Rebias the exponent from 127 to 15 and round away the 13 extra mantissa bits, ties to even
+        const std::uint32_t odd_mantissa{(bits >> 13) & 1u};
+        result = (bits - (112u << 23) + 0xfffu + odd_mantissa) >> 13;
+    }
+    return static_cast<std::uint16_t>(result | (sign >> 16));
+}
+
+// Store the lanes of a batch as IEEE binary16 bits, rounded to nearest even
+template<std::size_t Lanes>
+void store_half(FloatBatch<Lanes> batch, std::uint16_t* data)
+{
+    std::array<float, Lanes> values;
+    batch.store(values.data());
+    for (std::size_t lane = 0; lane < Lanes; ++lane)
+    {
+        data[lane] = to_half(values[lane]);
+    }
+}
+
+#ifdef TERRAIN_SIMD_F16C
+inline void store_half(FloatBatch<4> batch, std::uint16_t* data)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(data), _mm_cvtps_ph(batch.value, _MM_FROUND_TO_NEAREST_INT));
+}
+
+#ifdef __AVX__
+inline void store_half(FloatBatch<8> batch, std::uint16_t* data)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm256_cvtps_ph(batch.value, _MM_FROUND_TO_NEAREST_INT));
+}
+#endif
+#endif // TERRAIN_SIMD_F16C
+
+#ifdef __AVX512F__
+inline void store_half(FloatBatch<16> batch, std::uint16_t* data)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm512_cvtps_ph(batch.value, _MM_FROUND_TO_NEAREST_INT));
+}
+#endif
+
+// Scalar overloads, so templated kernels can also be instantiated for plain floats
+inline float floor(float value)
+{
+    return std::floor(value);
+}
+
+inline float abs(float value)
+{
+    return std::fabs(value);
+}
+
+inline float min(float a, float b)
+{
+    return b < a ? b : a;
+}
+
+inline float max(float a, float b)
+{
+    return a < b ? b : a;
+}
+
+} // namespace simd
+
+#endif // SIMD_HPP
\ No newline at end of file
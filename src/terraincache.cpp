@@ -0,0 +1,167 @@
+#include "terraincache.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+
+class Fnv1aHash
+{
+public:
+    template<typename T>
+    void add(T value)
+    {
+        static_assert(std::is_integral_v<T> || std::is_floating_point_v<T>);
+        std::uint64_t bits{0};
+        if constexpr (std::is_same_v<T, float>)
+        {
+            // std::bit_cast isn't available on every supported standard library
+            std::uint32_t float_bits{0};
+            std::memcpy(&float_bits, &value, sizeof(float));
+            bits = float_bits;
+        }
+        else
+        {
+            bits = static_cast<std::uint64_t>(value);
+        }
+
+        for (std::size_t byte = 0; byte < sizeof(T); ++byte)
+        {
+            hash_ ^= (bits >> (8 * byte)) & 0xFF;
+            hash_ *= 0x100000001B3;
+        }
+    }
+
+    std::uint64_t value() const
+    {
+        return hash_;
+    }
+
+private:
+    std::uint64_t hash_{0xCBF29CE484222325};
+};
+
+} // namespace
+
+std::uint64_t terrain_hash(const FractalNoiseGenerator::NoiseSettings& settings, std::span<const glm::vec2> offsets,
+                           std::uint32_t width, std::uint32_t height, bool apply_hermite_interpolation,
+                           NormalEncoding normal_encoding, std::optional<TileCoordinate> tile)
+{
+    Fnv1aHash hash;
+    hash.add(settings.exponent);
+    hash.add(settings.noise_scale);
+    hash.add(settings.lacunarity);
+    hash.add(settings.persistance);
+    hash.add(settings.octaves);
+    hash.add(settings.offset.x);
+    hash.add(settings.offset.y);
+    hash.add(settings.seed);
+    for (const glm::vec2 offset : offsets)
+    {
+        hash.add(offset.x);
+        hash.add(offset.y);
+    }
+    hash.add(width);
+    hash.add(height);
+    hash.add(apply_hermite_interpolation);
+    hash.add(static_cast<std::uint8_t>(normal_encoding));
+    hash.add(tile.has_value());
+    if (tile.has_value())
+    {
+        hash.add(tile->x);
+        hash.add(tile->y);
+        hash.add(tile->lod);
+    }
+    return hash.value();
+}
+
+std::size_t terrain_maps_size(const TerrainMaps& maps)
+{
+    return maps.height_map.pixels() * sizeof(float) + maps.normal_map.pixels() * sizeof(std::uint8_t);
+}
+
+TerrainCache::TerrainCache(std::size_t capacity_in_bytes) : capacity_in_bytes_{capacity_in_bytes}
+{
+}
+
+std::shared_ptr<const TerrainMaps> TerrainCache::find(std::uint64_t key)
+{
+    std::scoped_lock lock{mutex_};
+    auto search_iterator = index_.find(key);
+    if (search_iterator == index_.end())
+    {
+        ++statistics_.misses;
+        return nullptr;
+    }
+
+    ++statistics_.hits;
+    entries_.splice(entries_.begin(), entries_, search_iterator->second);
+    return search_iterator->second->second;
+}
+
+void TerrainCache::insert(std::uint64_t key, TerrainMaps maps)
+{
+    const std::size_t entry_size{terrain_maps_size(maps)};
+    if (entry_size > capacity_in_bytes_)
+    {
+        return;
+    }
+
+    std::scoped_lock lock{mutex_};
+    if (auto search_iterator = index_.find(key); search_iterator != index_.end())
+    {
+        size_in_bytes_ -= terrain_maps_size(*search_iterator->second->second);
+        entries_.erase(search_iterator->second);
+        index_.erase(search_iterator);
+    }
+
+    while (size_in_bytes_ + entry_size > capacity_in_bytes_)
+    {
+        evict_least_recently_used();
+    }
+
+    entries_.emplace_front(key, std::make_shared<const TerrainMaps>(std::move(maps)));
+    index_.emplace(key, entries_.begin());
+    size_in_bytes_ += entry_size;
+}
+
+void TerrainCache::evict_least_recently_used()
+{
+    const auto& [key, maps] = entries_.back();
+    size_in_bytes_ -= terrain_maps_size(*maps);
+    index_.erase(key);
+    entries_.pop_back();
+    ++statistics_.evictions;
+}
+
+void TerrainCache::clear()
+{
+    std::scoped_lock lock{mutex_};
+    entries_.clear();
+    index_.clear();
+    size_in_bytes_ = 0;
+}
+
+std::size_t TerrainCache::capacity_in_bytes() const
+{
+    return capacity_in_bytes_;
+}
+
+std::size_t TerrainCache::size_in_bytes() const
+{
+    std::scoped_lock lock{mutex_};
+    return size_in_bytes_;
+}
+
+std::size_t TerrainCache::entries() const
+{
+    std::scoped_lock lock{mutex_};
+    return entries_.size();
+}
+
+TerrainCache::Statistics TerrainCache::statistics() const
+{
+    std::scoped_lock lock{mutex_};
+    return statistics_;
+}
\ No newline at end of file
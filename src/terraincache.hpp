@@ -0,0 +1,102 @@
+#ifndef TERRAIN_CACHE_HPP
+#define TERRAIN_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "image.hpp"
+#include "noisegeneration.hpp"
+
+struct TerrainMaps
+{
+    Image<float> height_map;
+    Image<std::uint8_t> normal_map;
+};
+
+struct TileCoordinate
+{
+    std::int64_t x{0};
+    std::int64_t y{0};
+    std::uint32_t lod{0};
+};
+
+/*
+Stable 64-bit hash (FNV-1a over the bit patterns of every field) identifying
+a generated terrain: the noise settings, the random offsets actually used,
+the resolution, whether the Hermite redistribution is applied, the normal map
+encoding and, for tiles, the tile coordinate. The hash doesn't depend on the platform or on the
+process, so it can also be used to name results stored on disk.
+*/
+std::uint64_t terrain_hash(const FractalNoiseGenerator::NoiseSettings& settings, std::span<const glm::vec2> offsets,
+                           std::uint32_t width, std::uint32_t height, bool apply_hermite_interpolation,
+                           NormalEncoding normal_encoding = NormalEncoding::rgba,
+                           std::optional<TileCoordinate> tile = std::nullopt);
+
+/*
+Bounded-memory cache of generated height and normal maps with least
+recently used eviction. Entries are identified by terrain_hash and shared
+with the callers, so an entry stays alive while in use even if it's evicted.
+All member functions are thread-safe.
+*/
+class TerrainCache
+{
+public:
+    struct Statistics
+    {
+        std::size_t hits{0};
+        std::size_t misses{0};
+        std::size_t evictions{0};
+    };
+
+    explicit TerrainCache(std::size_t capacity_in_bytes);
+    TerrainCache(const TerrainCache&) = delete;
+    TerrainCache(TerrainCache&&) = delete;
+    TerrainCache& operator=(const TerrainCache&) = delete;
+    TerrainCache& operator=(TerrainCache&&) = delete;
+    ~TerrainCache() = default;
+
+    /*
+    Return the maps stored with the given key, or nullptr if there are none.
+    A successful lookup marks the entry as the most recently used one.
+    */
+    std::shared_ptr<const TerrainMaps> find(std::uint64_t key);
+
+    /*
+    Store maps with the given key, evicting the least recently used
+    entries until the cache fits its capacity. Maps larger than the
+    whole capacity are not stored.
+    */
+    void insert(std::uint64_t key, TerrainMaps maps);
+    void clear();
+
+    std::size_t capacity_in_bytes() const;
+    std::size_t size_in_bytes() const;
+    std::size_t entries() const;
+    Statistics statistics() const;
+
+private:
+    using Entry = std::pair<std::uint64_t, std::shared_ptr<const TerrainMaps>>;
+
+    const std::size_t capacity_in_bytes_;
+    std::size_t size_in_bytes_{0};
+    Statistics statistics_{};
+    // Most recently used entries are at the front of the list
+    std::list<Entry> entries_;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index_;
+    mutable std::mutex mutex_;
+
+    void evict_least_recently_used();
+};
+
+// Memory used by the pixels of both maps
+std::size_t terrain_maps_size(const TerrainMaps& maps);
+
+#endif // TERRAIN_CACHE_HPP
\ No newline at end of file
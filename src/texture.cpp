@@ -41,6 +41,10 @@ void Texture::set_texture_parameters()
     glTextureParameteri(id_, GL_TEXTURE_WRAP_R, attributes_.wrap_r);
     glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, attributes_.min_filter);
     glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, attributes_.mag_filter);
+    if (attributes_.swizzle.has_value())
+    {
+        glTextureParameteriv(id_, GL_TEXTURE_SWIZZLE_RGBA, attributes_.swizzle->data());
+    }
 }
 
 Texture::Texture(std::uint32_t width, std::uint32_t height) : width_{width}, height_{height}
@@ -306,4 +310,73 @@ Texture create_arraytexture_from_file(const std::vector<std::string_view>& filen
     }
 
     return texture;
+}
+
+Texture::Attributes single_channel_attributes(GLenum internal_format)
+{
+    Texture::Attributes attributes{
+        .internal_format = internal_format,
+        .pixel_data_format = GL_RED,
+        .swizzle = std::array<GLint, 4>{GL_RED, GL_RED, GL_RED, GL_ONE},
+    };
+
+    switch (internal_format)
+    {
+    case GL_R8:
+        attributes.pixel_data_type = GL_UNSIGNED_BYTE;
+        break;
+    case GL_R16:
+        attributes.pixel_data_type = GL_UNSIGNED_SHORT;
+        break;
+    case GL_R32F:
+        attributes.pixel_data_type = GL_FLOAT;
+        break;
+    default:
+        throw std::invalid_argument("Unsupported single-channel internal format");
+    }
+    return attributes;
+}
+
+Texture::Attributes two_channel_attributes(GLenum internal_format)
+{
+    Texture::Attributes attributes{
+        .internal_format = internal_format,
+        .pixel_data_format = GL_RG,
+    };
+
+    switch (internal_format)
+    {
+    case GL_RG8:
+        attributes.pixel_data_type = GL_UNSIGNED_BYTE;
+        break;
+    case GL_RG16:
+        attributes.pixel_data_type = GL_UNSIGNED_SHORT;
+        break;
+    default:
+        throw std::invalid_argument("Unsupported two-channel internal format");
+    }
+    return attributes;
+}
+
+std::string_view image_format_qualifier(GLenum internal_format)
+{
+    switch (internal_format)
+    {
+    case GL_R8:
+        return "r8";
+    case GL_R16:
+        return "r16";
+    case GL_R32F:
+        return "r32f";
+    case GL_RG8:
+        return "rg8";
+    case GL_RG16:
+        return "rg16";
+    case GL_RGBA8:
+        return "rgba8";
+    case GL_RGBA32F:
+        return "rgba32f";
+    default:
+        throw std::invalid_argument("Internal format has no image format qualifier");
+    }
 }
\ No newline at end of file
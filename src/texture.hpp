@@ -28,6 +28,8 @@ public:
         bool generate_mipmap{false};
         GLsizei mip_levels{1};
         std::optional<GLsizei> layers{};
+        // Source channel of each of the RGBA components when sampling
+        std::optional<std::array<GLint, 4>> swizzle{};
     };
 
     Texture(std::uint32_t width, std::uint32_t height, Attributes attributes);
@@ -42,9 +44,21 @@ public:
     template <typename T>
     void copy_image(const Image<T>& image);
 
+    // Uploads a view whose rows may be padded, or a rectangle of a larger image
+    template <typename T>
+    void copy_image(ImageView<T> image);
+
     template <typename T>
     void copy_image(const T* image_data, std::int32_t width, std::int32_t height);
 
+    /*
+    Start reading the base level back, converted to T, into the buffer
+    bound to GL_PIXEL_PACK_BUFFER at the given byte offset. The call
+    doesn't wait for the copy; a fence tells when the data can be mapped.
+    */
+    template <typename T>
+    void read_image(std::size_t buffer_offset, std::size_t size) const;
+
     template <typename T>
     void copy_image_array(const std::vector<T*> image_data, std::int32_t width, std::int32_t height);
 
@@ -75,6 +89,19 @@ Texture create_texture_from_file(std::string_view filename, Texture::Attributes
 Texture create_arraytexture_from_file(const std::vector<std::string_view>& filenames,
                                       Texture::Attributes attributes = {}, bool flip_on_load = true);
 
+/*
+Attributes of a single-channel 2D texture with the given internal format
+(GL_R8, GL_R16 or GL_R32F). The red channel is replicated on sampling,
+so it shows up as grayscale when displayed.
+*/
+Texture::Attributes single_channel_attributes(GLenum internal_format);
+
+// Attributes of a two-channel 2D texture with the given internal format (GL_RG8 or GL_RG16)
+Texture::Attributes two_channel_attributes(GLenum internal_format);
+
+// GLSL layout qualifier of an image with the given internal format, e.g. "r16" for GL_R16
+std::string_view image_format_qualifier(GLenum internal_format);
+
 #include "texture.inl"
 
 #endif // TEXTURE_HPP
\ No newline at end of file
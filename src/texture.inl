@@ -1,10 +1,49 @@
 #include "texture.hpp"
 #include <stdexcept>
+#include <type_traits>
+
+namespace texture_detail
+{
+
+// Pixel data type of client memory holding values of type T
+template <typename T>
+constexpr GLenum pixel_data_type()
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return GL_FLOAT;
+    }
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+    {
+        return GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        static_assert(std::is_same_v<T, std::uint8_t>, "Unsupported pixel type");
+        return GL_UNSIGNED_BYTE;
+    }
+}
+
+} // namespace texture_detail
 
 template <typename T>
 void Texture::copy_image(const Image<T>& image)
 {
-    copy_image(static_cast<const T*>(image.data()), image.width(), image.height());
+    copy_image(image.view());
+}
+
+template <typename T>
+void Texture::copy_image(ImageView<T> image)
+{
+    // The row length is counted in pixels; padded rows are not necessarily a multiple of 4 bytes apart
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(image.pitch() / image.depth()));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // The view knows its element type, so it's uploaded as such whatever the texture's pixel data type
+    glTextureSubImage2D(id_, 0, 0, 0, static_cast<GLsizei>(image.width()), static_cast<GLsizei>(image.height()),
+                        attributes_.pixel_data_format, texture_detail::pixel_data_type<T>(), image.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    generate_mipmap();
 }
 
 template <typename T>
@@ -15,6 +54,15 @@ void Texture::copy_image(const T* image_data, std::int32_t width, std::int32_t h
     generate_mipmap();
 }
 
+template <typename T>
+void Texture::read_image(std::size_t buffer_offset, std::size_t size) const
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(id_, 0, attributes_.pixel_data_format, texture_detail::pixel_data_type<T>(),
+                      static_cast<GLsizei>(size), reinterpret_cast<void*>(buffer_offset));
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
 template <typename T>
 void Texture::copy_image_array(const std::vector<T*> image_data, std::int32_t width, std::int32_t height)
 {
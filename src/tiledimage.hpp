@@ -0,0 +1,70 @@
+#ifndef TILED_IMAGE_HPP
+#define TILED_IMAGE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "image.hpp"
+#include "imageview.hpp"
+
+/*
+Image stored in square blocks of block_size x block_size pixels, each
+block being row-major and the blocks being laid out row by row. A 3x3
+stencil or a bilinear sample then stays within one or two blocks (a few
+pages) instead of touching rows width * depth values apart, which
+improves cache and TLB hit rates on wide maps. The get/set API matches
+Image, so code templated on the image type works with either layout;
+to_tiled and to_row_major convert between the two (e.g. to upload or
+save a tiled image). Storage is padded to whole blocks and aligned like
+Image.
+*/
+template<typename T>
+class TiledImage
+{
+public:
+    static constexpr std::size_t block_size{64};
+
+    TiledImage(std::size_t width, std::size_t height, std::size_t depth = 1);
+
+    T get(std::size_t i, std::size_t j, std::size_t k = 0) const;
+
+    template<typename RandomAccessIterator>
+    void set(std::size_t i, std::size_t j, RandomAccessIterator begin, RandomAccessIterator end);
+    void set(std::size_t i, std::size_t j, std::size_t k, T value);
+
+    // Block (block_row, block_column) as a view, clipped to the image; rows are block_size pixels apart
+    ImageView<T> block(std::size_t block_row, std::size_t block_column) const;
+    MutableImageView<T> mutable_block(std::size_t block_row, std::size_t block_column);
+
+    T* data();
+    const T* data() const;
+
+    std::size_t width() const;
+    std::size_t height() const;
+    std::size_t depth() const;
+    std::size_t pixels() const;
+    std::size_t block_rows() const;
+    std::size_t block_columns() const;
+
+private:
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::size_t depth_{1};
+    std::size_t block_rows_{0};
+    std::size_t block_columns_{0};
+    std::vector<T, AlignedAllocator<T>> image_data_;
+
+    std::size_t index(std::size_t i, std::size_t j) const;
+};
+
+// Copy an image (or a view of part of one) to the tiled layout, splitting the block rows across workers
+template<typename T>
+TiledImage<T> to_tiled(ImageView<T> image, std::size_t workers = 1);
+
+// Copy a tiled image back to the row-major layout of Image
+template<typename T>
+Image<T> to_row_major(const TiledImage<T>& image, RowPadding padding = RowPadding::none, std::size_t workers = 1);
+
+#include "tiledimage.inl"
+
+#endif // TILED_IMAGE_HPP
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "tiledimage.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+#include "parallel.hpp"
+
+template<typename T>
+TiledImage<T>::TiledImage(std::size_t width, std::size_t height, std::size_t depth) :
+    width_{width}, height_{height}, depth_{depth}, block_rows_{(height + block_size - 1) / block_size},
+    block_columns_{(width + block_size - 1) / block_size},
+    image_data_(block_rows_ * block_columns_ * block_size * block_size * depth)
+{
+    static_assert(std::is_arithmetic_v<T>, "TiledImage underlying type must be numeric");
+}
+
+template<typename T>
+std::size_t TiledImage<T>::index(std::size_t i, std::size_t j) const
+{
+    // block_size is a power of two, so the divisions and remainders reduce to shifts and masks
+    const std::size_t block_index{(i / block_size) * block_columns_ + j / block_size};
+    const std::size_t offset{(i % block_size) * block_size + j % block_size};
+    return (block_index * block_size * block_size + offset) * depth_;
+}
+
+template<typename T>
+T TiledImage<T>::get(std::size_t i, std::size_t j, std::size_t k) const
+{
+    return image_data_[index(i, j) + k];
+}
+
+template<typename T>
+template<typename RandomAccessIterator>
+void TiledImage<T>::set(std::size_t i, std::size_t j, RandomAccessIterator begin, RandomAccessIterator end)
+{
+    assert(static_cast<std::size_t>(end - begin) == depth_);
+    std::copy(begin, end, image_data_.begin() + index(i, j));
+}
+
+template<typename T>
+void TiledImage<T>::set(std::size_t i, std::size_t j, std::size_t k, T value)
+{
+    image_data_[index(i, j) + k] = value;
+}
+
+template<typename T>
+ImageView<T> TiledImage<T>::block(std::size_t block_row, std::size_t block_column) const
+{
+    assert(block_row < block_rows_ && block_column < block_columns_);
+    const std::size_t first_row{block_row * block_size};
+    const std::size_t first_column{block_column * block_size};
+    return ImageView<T>{image_data_.data() + index(first_row, first_column),
+                        std::min(block_size, width_ - first_column), std::min(block_size, height_ - first_row),
+                        depth_, block_size * depth_};
+}
+
+template<typename T>
+MutableImageView<T> TiledImage<T>::mutable_block(std::size_t block_row, std::size_t block_column)
+{
+    assert(block_row < block_rows_ && block_column < block_columns_);
+    const std::size_t first_row{block_row * block_size};
+    const std::size_t first_column{block_column * block_size};
+    return MutableImageView<T>{image_data_.data() + index(first_row, first_column),
+                               std::min(block_size, width_ - first_column), std::min(block_size, height_ - first_row),
+                               depth_, block_size * depth_};
+}
+
+template<typename T>
+T* TiledImage<T>::data()
+{
+    return image_data_.data();
+}
+
+template<typename T>
+const T* TiledImage<T>::data() const
+{
+    return image_data_.data();
+}
+
+template<typename T>
+std::size_t TiledImage<T>::width() const
+{
+    return width_;
+}
+
+template<typename T>
+std::size_t TiledImage<T>::height() const
+{
+    return height_;
+}
+
+template<typename T>
+std::size_t TiledImage<T>::depth() const
+{
+    return depth_;
+}
+
+template<typename T>
+std::size_t TiledImage<T>::pixels() const
+{
+    return width_ * height_ * depth_;
+}
+
+template<typename T>
+std::size_t TiledImage<T>::block_rows() const
+{
+    return block_rows_;
+}
+
+template<typename T>
+std::size_t TiledImage<T>::block_columns() const
+{
+    return block_columns_;
+}
+
+template<typename T>
+TiledImage<T> to_tiled(ImageView<T> image, std::size_t workers)
+{
+    TiledImage<T> tiled{image.width(), image.height(), image.depth()};
+    // Every row of a block is a contiguous run of both layouts
+    parallel_for_bands(tiled.block_rows(), workers, [&](std::size_t, std::size_t first_block, std::size_t last_block) {
+        for (std::size_t block_row = first_block; block_row < last_block; ++block_row)
+        {
+            for (std::size_t block_column = 0; block_column < tiled.block_columns(); ++block_column)
+            {
+                const MutableImageView<T> block = tiled.mutable_block(block_row, block_column);
+                const ImageView<T> source = image.subview(block_row * TiledImage<T>::block_size,
+                                                          block_column * TiledImage<T>::block_size, block.height(),
+                                                          block.width());
+                for (std::size_t i = 0; i < block.height(); ++i)
+                {
+                    std::copy(source.row(i), source.row(i) + block.width() * block.depth(), block.row(i));
+                }
+            }
+        }
+    });
+    return tiled;
+}
+
+template<typename T>
+Image<T> to_row_major(const TiledImage<T>& image, RowPadding padding, std::size_t workers)
+{
+    Image<T> row_major{image.width(), image.height(), image.depth(), padding};
+    const MutableImageView<T> destination = row_major.mutable_view();
+    parallel_for_bands(image.block_rows(), workers, [&](std::size_t, std::size_t first_block, std::size_t last_block) {
+        for (std::size_t block_row = first_block; block_row < last_block; ++block_row)
+        {
+            for (std::size_t block_column = 0; block_column < image.block_columns(); ++block_column)
+            {
+                const ImageView<T> block = image.block(block_row, block_column);
+                const MutableImageView<T> target =
+                    destination.subview(block_row * TiledImage<T>::block_size,
+                                        block_column * TiledImage<T>::block_size, block.height(), block.width());
+                for (std::size_t i = 0; i < block.height(); ++i)
+                {
+                    std::copy(block.row(i), block.row(i) + block.width() * block.depth(), target.row(i));
+                }
+            }
+        }
+    });
+    return row_major;
+}
\ No newline at end of file